@@ -1050,6 +1050,8 @@ uint8_t RF_PKTCTRL0;
 #define RF_PKTCTRL0_CRC_EN                 (1 << 2)
 #define RF_PKTCTRL0_LENGTH_CONFIG_FIXED    (0 << 0)
 #define RF_PKTCTRL0_LENGTH_CONFIG_VARIABLE (1 << 0)
+#define RF_PKTCTRL0_LENGTH_CONFIG_INFINITE (2 << 0)
+#define RF_PKTCTRL0_LENGTH_CONFIG_MASK     (3 << 0)
 
 __xdata __at (0xdf05)
 uint8_t RF_ADDR;
@@ -1175,10 +1177,12 @@ uint8_t RF_MCSM1;
 #define RF_MCSM1_RXOFF_MODE_FSTXON                    (1 << 2)
 #define RF_MCSM1_RXOFF_MODE_TX                        (2 << 2)
 #define RF_MCSM1_RXOFF_MODE_RX                        (3 << 2)
+#define RF_MCSM1_RXOFF_MODE_MASK                      (3 << 2)
 #define RF_MCSM1_TXOFF_MODE_IDLE                      (0 << 0)
 #define RF_MCSM1_TXOFF_MODE_FSTXON                    (1 << 0)
 #define RF_MCSM1_TXOFF_MODE_TX                        (2 << 0)
 #define RF_MCSM1_TXOFF_MODE_RX                        (3 << 0)
+#define RF_MCSM1_TXOFF_MODE_MASK                      (3 << 0)
 
 __xdata __at (0xdf14)
 uint8_t RF_MCSM0;
@@ -1187,6 +1191,7 @@ uint8_t RF_MCSM0;
 #define RF_MCSM0_FS_AUTOCAL_FROM_IDLE       (1 << 4)
 #define RF_MCSM0_FS_AUTOCAL_TO_IDLE         (2 << 4)
 #define RF_MCSM0_FS_AUTOCAL_TO_IDLE_EVERY_4 (3 << 4)
+#define RF_MCSM0_FS_AUTOCAL_MASK            (3 << 4)
 #define RF_MCSM0_MAGIC_3                    (1 << 3)
 #define RF_MCSM0_MAGIC_2                    (1 << 2)
 #define RF_MCSM0_CLOSE_IN_RX_0DB            (0 << 0)
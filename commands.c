@@ -34,6 +34,11 @@ void command_do(uint8_t cmd) {
 			usb_tx_bytes("keinechterdeutscher@gmail.com", 29);
 			break;
 
+		// Set framing
+		case 2:
+			command_framing();
+			break;
+
 		// Get register
 		case 10:
 			command_register_read();
@@ -44,6 +49,46 @@ void command_do(uint8_t cmd) {
 			command_register_write();
 			break;
 
+		// Set radio options
+		case 12:
+			command_radio_options();
+			break;
+
+		// Get radio statistics
+		case 13:
+			command_radio_stats();
+			break;
+
+		// Set radio packet mode
+		case 14:
+			command_radio_packet();
+			break;
+
+		// Calibrate radio channels
+		case 15:
+			command_radio_calibrate();
+			break;
+
+		// Get registers
+		case 16:
+			command_registers_read();
+			break;
+
+		// Set registers
+		case 17:
+			command_registers_write();
+			break;
+
+		// Set listed registers
+		case 18:
+			command_registers_write_list();
+			break;
+
+		// Set radio locale
+		case 19:
+			command_radio_locale();
+			break;
+
 		// Receive radio packets
 		case 20:
 			command_radio_receive();
@@ -59,6 +104,41 @@ void command_do(uint8_t cmd) {
 			command_radio_send_receive();
 			break;
 
+		// Stream radio packets
+		case 23:
+			command_radio_stream();
+			break;
+
+		// Detect radio locale
+		case 24:
+			command_radio_detect_locale();
+			break;
+
+		// Set radio CRC policy
+		case 25:
+			command_radio_crc();
+			break;
+
+		// Set radio address filter
+		case 26:
+			command_radio_filter();
+			break;
+
+		// Download pump history page
+		case 27:
+			command_history_download();
+			break;
+
+		// Save radio TX template
+		case 28:
+			command_template_save();
+			break;
+
+		// Send radio TX template
+		case 29:
+			command_template_send();
+			break;
+
 		// Toggle LED
 		case 30:
 			command_led_toggle();
@@ -73,9 +153,74 @@ void command_do(uint8_t cmd) {
 		case 32:
 			command_led_off();
 			break;
+
+		// Stage radio packet
+		case 33:
+			command_radio_stage();
+			break;
+
+		// Send staged radio packet and receive radio packets
+		case 34:
+			command_radio_flip_send_receive();
+			break;
+
+		// Send radio packet burst
+		case 35:
+			command_radio_burst();
+			break;
+
+		// Send radio packet and listen for answer right away
+		case 36:
+			command_radio_send_listen();
+			break;
+
+		// Send radio packet at given time
+		case 37:
+			command_radio_send_at();
+			break;
+
+		// Get time
+		case 38:
+			command_time();
+			break;
+
+		// Apply radio profile
+		case 40:
+			command_profile_apply();
+			break;
+
+		// Save radio profile
+		case 41:
+			command_profile_save();
+			break;
+
+		// Erase radio profile
+		case 42:
+			command_profile_erase();
+			break;
+
+		// Get radio profile
+		case 43:
+			command_profile_get();
+			break;
 	}
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_FRAMING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Answer already uses framing applied.
+*/
+void command_framing(void) {
+
+	// Read framing version
+	uint8_t framing = usb_rx_byte();
+
+	// Set it and tell master which one was applied
+	usb_tx_byte(radio_set_framing(framing));
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     COMMAND_REGISTER_READ
@@ -102,8 +247,186 @@ void command_register_write(void) {
 	uint8_t addr = usb_rx_byte();
 	uint8_t value = usb_rx_byte();
 
+	// Stop radio from listening in the background
+	radio_rx_stop();
+
 	// Write register value
 	*radio_register(addr) = value;
+
+	// Forget channel calibrations made with other settings
+	radio_cal_clear();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_REGISTERS_READ
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send values of a range of registers in one go (0 for unknown ones).
+*/
+void command_registers_read(void) {
+
+	// Read first register address and number of registers
+	uint8_t addr = usb_rx_byte();
+	uint8_t n = usb_rx_byte();
+
+	// Initialize register pointer
+	uint8_t *reg;
+
+	// Announce values
+	usb_put_length(n);
+
+	// Put them
+	while (n--) {
+		reg = radio_register(addr++);
+		usb_put_byte(reg ? *reg : 0);
+	}
+
+	// Send them to master
+	usb_flush_bytes();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_REGISTERS_WRITE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Write values of a range of registers in one go (unknown ones skipped), and
+    tell master how many were written.
+*/
+void command_registers_write(void) {
+
+	// Read first register address and number of registers
+	uint8_t addr = usb_rx_byte();
+	uint8_t n = usb_rx_byte();
+
+	// Initialize register pointer, value and write count
+	uint8_t *reg;
+	uint8_t value;
+	uint8_t count = 0;
+
+	// Stop radio from listening in the background
+	radio_rx_stop();
+
+	// Write values
+	while (n--) {
+		reg = radio_register(addr++);
+		value = usb_rx_byte();
+
+		// If register known
+		if (reg) {
+			*reg = value;
+			count++;
+		}
+	}
+
+	// Forget channel calibrations made with other settings
+	radio_cal_clear();
+
+	// Tell master how many registers were written
+	usb_tx_byte(count);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_REGISTERS_WRITE_LIST
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Write (address, value) pairs in one go (unknown registers skipped), and
+    tell master how many were written.
+*/
+void command_registers_write_list(void) {
+
+	// Read number of pairs
+	uint8_t n = usb_rx_byte();
+
+	// Initialize register pointer, value and write count
+	uint8_t *reg;
+	uint8_t value;
+	uint8_t count = 0;
+
+	// Stop radio from listening in the background
+	radio_rx_stop();
+
+	// Write values
+	while (n--) {
+		reg = radio_register(usb_rx_byte());
+		value = usb_rx_byte();
+
+		// If register known
+		if (reg) {
+			*reg = value;
+			count++;
+		}
+	}
+
+	// Forget channel calibrations made with other settings
+	radio_cal_clear();
+
+	// Tell master how many registers were written
+	usb_tx_byte(count);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_OPTIONS
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_options(void) {
+
+	// Read options
+	uint8_t options = usb_rx_byte();
+
+	// Set them and tell master which ones were applied
+	usb_tx_byte(radio_set_options(options));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_STATS
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_stats(void) {
+
+	// Send radio statistics to master
+	radio_get_stats();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_PACKET
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_packet(void) {
+
+	// Read packet mode and length
+	uint8_t packet = usb_rx_byte();
+	uint8_t length = usb_rx_byte();
+
+	// Set them and tell master which mode was applied
+	usb_tx_byte(radio_set_packet(packet, length));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_CALIBRATE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_calibrate(void) {
+
+	// Calibrate channels and tell master how many
+	usb_tx_byte(radio_calibrate());
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_LOCALE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_locale(void) {
+
+	// Read locale
+	uint8_t locale = usb_rx_byte();
+
+	// Set it and tell master which one was applied
+	usb_tx_byte(radio_set_locale(locale));
 }
 
 /*
@@ -135,6 +458,8 @@ void command_radio_receive(void) {
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     COMMAND_RADIO_SEND
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Nothing comes back, unless packet sent with cut-through was lost: error
+    then.
 */
 void command_radio_send(void) {
 
@@ -143,8 +468,15 @@ void command_radio_send(void) {
 	uint8_t repeat = usb_rx_byte();
 	uint32_t delay = usb_rx_long();
 
-	// Send bytes to radio
-	radio_send(channel, repeat, delay);
+	// Send bytes to radio and get error if there is one
+	uint8_t error = radio_send(channel, repeat, delay);
+
+	// If error
+	if (error != 0) {
+
+		// Send error to master
+		usb_tx_byte(error);
+	}
 }
 
 /*
@@ -154,6 +486,44 @@ void command_radio_send(void) {
 */
 void command_radio_send_receive(void) {
 
+	// Send packet from master and receive answer
+	command_radio_exchange(0);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_STAGE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_stage(void) {
+
+	// Read next packet to send into staged TX buffer
+	radio_tx_stage();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_FLIP_SEND_RECEIVE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_flip_send_receive(void) {
+
+	// Send staged packet and receive answer, while master stages next one
+	command_radio_exchange(1);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_EXCHANGE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet (from master, or staged one), then receive answer, resending
+    packet on timeout as many times as asked. With staged packet, one more
+    parameter byte says whether master sends next packet right after
+    parameters: if so, it is staged while radio listens, or once answer came,
+    and only bytes after it interrupt. Otherwise, any byte interrupts.
+*/
+void command_radio_exchange(uint8_t staged) {
+
 	// Get channel, repeat and delay (ms) for sending part
 	uint8_t tx_channel = usb_rx_byte();
 	uint8_t tx_repeat = usb_rx_byte();
@@ -167,14 +537,33 @@ void command_radio_send_receive(void) {
 	uint8_t error = 0;
 	uint8_t retry = usb_rx_byte();
 
-	// Send bytes to then receive some from radio
-	radio_send(tx_channel, tx_repeat, tx_delay);
+	// Get whether master sends next packet to stage (staged packet only)
+	uint8_t next = staged ? usb_rx_byte() : 0;
+
+	// If packet staged
+	if (staged) {
+
+		// Send it, and stage next one from master while receiving (if
+		// announced)
+		radio_send_staged(tx_channel, tx_repeat, tx_delay);
+		radio_set_staging(next);
+	}
+
+	// Otherwise
+	else {
+
+		// Send bytes to then receive some from radio
+		radio_send(tx_channel, tx_repeat, tx_delay);
+	}
 
 	// Read bytes from radio and get error if there is one
 	error = radio_receive(rx_channel, rx_timeout);
 
-	// Retry until no timeout and no retries left
-	while (error == RADIO_ERROR_TIMEOUT && retry > 0) {
+	// Retry until no timeout (nor wrong CRC, if policy says so) and no
+	// retries left
+	while ((error == RADIO_ERROR_TIMEOUT ||
+	        (error == RADIO_ERROR_CRC &&
+	         (radio_get_crc() & RADIO_CRC_RETRY))) && retry > 0) {
 
 		// Resend packet in TX buffer
 		radio_resend();
@@ -186,6 +575,10 @@ void command_radio_send_receive(void) {
 		retry--;
 	}
 
+	// Make sure announced packet is staged: bytes from master mean
+	// interruption again then
+	radio_set_staging(0);
+
 	// If error
 	if (error != 0) {
 
@@ -194,6 +587,355 @@ void command_radio_send_receive(void) {
 	}
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_BURST
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Packet follows parameters. Time taken by burst (us, MSB first) comes back,
+    so master gets packet rate achieved.
+*/
+void command_radio_burst(void) {
+
+	// Get channel, packet count and period (us)
+	uint8_t channel = usb_rx_byte();
+	uint16_t count = usb_rx_word();
+	uint32_t period = usb_rx_long();
+
+	// Initialize time taken (us)
+	uint8_t time[4];
+
+	// Send packets
+	uint32_t t = radio_burst(channel, count, period);
+
+	// Send time taken to master
+	time[0] = t >> 24;
+	time[1] = t >> 16;
+	time[2] = t >> 8;
+	time[3] = t;
+	usb_tx_bytes(time, 4);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_SEND_LISTEN
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Packet follows parameters. Answer comes back as with send and receive.
+*/
+void command_radio_send_listen(void) {
+
+	// Get channel, and deadlines (us) for sync word and end of answer
+	uint8_t channel = usb_rx_byte();
+	uint32_t sync = usb_rx_long();
+	uint32_t end = usb_rx_long();
+
+	// Get retry count
+	uint8_t retry = usb_rx_byte();
+
+	// Send packet and receive answer, and get error if there is one
+	uint8_t error = radio_send_listen(channel, sync, end, retry);
+
+	// If error
+	if (error != 0) {
+
+		// Send error to master
+		usb_tx_byte(error);
+	}
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_SEND_AT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Packet follows parameters. Time is device time (us), as given by time
+    command. Whether packet was sent (0), or error, comes back.
+*/
+void command_radio_send_at(void) {
+
+	// Get channel and time (us)
+	uint8_t channel = usb_rx_byte();
+	uint32_t time = usb_rx_long();
+
+	// Send packet then, and tell master how it went
+	usb_tx_byte(radio_send_at(channel, time));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_STREAM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_stream(void) {
+
+	// Get channel and total timeout (ms)
+	uint8_t channel = usb_rx_byte();
+	uint32_t timeout = usb_rx_long();
+
+	// Send packets to master as they come and get reason for stopping
+	uint8_t error = radio_stream(channel, timeout);
+
+	// Tell master stream is over
+	usb_tx_byte(error);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_DETECT_LOCALE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Packet to probe with follows parameters. Answer (if any) comes first, then
+    locale found, or error.
+*/
+void command_radio_detect_locale(void) {
+
+	// Get channels and timeout (ms)
+	uint8_t tx_channel = usb_rx_byte();
+	uint8_t rx_channel = usb_rx_byte();
+	uint32_t timeout = usb_rx_long();
+
+	// Probe locales and get error if there is one
+	uint8_t error = radio_detect_locale(tx_channel, rx_channel, timeout);
+
+	// Send locale or error to master
+	usb_tx_byte(error ? error : radio_get_locale());
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_CRC
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_radio_crc(void) {
+
+	// Read CRC policy
+	uint8_t crc = usb_rx_byte();
+
+	// Set it and tell master which one was applied
+	usb_tx_byte(radio_set_crc(crc));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_RADIO_FILTER
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Flags and number of bytes come first, then bytes, then their mask. Bytes
+    beyond filter size are read but dropped.
+*/
+void command_radio_filter(void) {
+
+	// Initialize filter bytes and mask
+	uint8_t bytes[RADIO_FILTER_SIZE];
+	uint8_t mask[RADIO_FILTER_SIZE];
+	uint8_t n = 0;
+	uint8_t byte;
+
+	// Read flags and number of bytes
+	uint8_t flags = usb_rx_byte();
+	uint8_t size = usb_rx_byte();
+
+	// Read bytes
+	while (n < size) {
+		byte = usb_rx_byte();
+
+		if (n < RADIO_FILTER_SIZE) {
+			bytes[n] = byte;
+		}
+
+		n++;
+	}
+
+	// Read mask
+	n = 0;
+
+	while (n < size) {
+		byte = usb_rx_byte();
+
+		if (n < RADIO_FILTER_SIZE) {
+			mask[n] = byte;
+		}
+
+		n++;
+	}
+
+	// Set filter and tell master how many bytes it compares on air
+	usb_tx_byte(radio_set_filter(flags, size, bytes, mask));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_HISTORY_DOWNLOAD
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Page request (decoded) follows parameters. Page (if complete) comes first,
+    then whether its CRC is right (0), or error.
+*/
+void command_history_download(void) {
+
+	// Get channels, timeout (ms) per frame and retry count
+	uint8_t tx_channel = usb_rx_byte();
+	uint8_t rx_channel = usb_rx_byte();
+	uint32_t timeout = usb_rx_long();
+	uint8_t retries = usb_rx_byte();
+
+	// Download page and send master its CRC verdict
+	usb_tx_byte(history_download(tx_channel, rx_channel, timeout, retries));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_TEMPLATE_SAVE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Template index and number of bytes come first, then bytes (without zero
+    byte ending packets with zero framing, which is added when sending).
+*/
+void command_template_save(void) {
+
+	// Initialize byte index
+	uint8_t n = 0;
+
+	// Read template index and number of bytes
+	uint8_t index = usb_rx_byte();
+	uint8_t size = usb_rx_byte();
+
+	// Make template
+	index = radio_template_save(index, size);
+
+	// Read its bytes (dropped if template unknown)
+	while (n < size) {
+		radio_template_patch(index, n, usb_rx_byte());
+		n++;
+	}
+
+	// Tell master which template was saved
+	usb_tx_byte(index);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_TEMPLATE_SEND
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Template index, channel, flags (e.g. compute CRC8 again, with encoding
+    only) and number of patches come first, then patches (byte offset and
+    value each).
+*/
+void command_template_send(void) {
+
+	// Read template index, channel, flags and number of patches
+	uint8_t index = usb_rx_byte();
+	uint8_t channel = usb_rx_byte();
+	uint8_t flags = usb_rx_byte();
+	uint8_t n = usb_rx_byte();
+
+	// Initialize byte offset
+	uint8_t offset;
+
+	// Patch template
+	while (n > 0) {
+		offset = usb_rx_byte();
+		radio_template_patch(index, offset, usb_rx_byte());
+		n--;
+	}
+
+	// Send it
+	radio_template_send(index, channel, flags);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_TIME
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Device time (us since timer started, wrapping after ~71 minutes) comes
+    back MSB first, as RX timestamps do, so master can schedule against it.
+*/
+void command_time(void) {
+
+	// Initialize time bytes
+	uint8_t time[4];
+
+	// Get time
+	uint32_t t = timer_now();
+
+	// Send it to master
+	time[0] = t >> 24;
+	time[1] = t >> 16;
+	time[2] = t >> 8;
+	time[3] = t;
+	usb_tx_bytes(time, 4);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_PROFILE_APPLY
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_profile_apply(void) {
+
+	// Read profile index
+	uint8_t index = usb_rx_byte();
+
+	// Apply profile and tell master which one was applied
+	usb_tx_byte(radio_profile_apply(index));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_PROFILE_SAVE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Current register values are saved under given name.
+*/
+void command_profile_save(void) {
+
+	// Initialize profile name
+	uint8_t name[RADIO_PROFILE_NAME_SIZE];
+	uint8_t n = 0;
+
+	// Read profile index and name
+	uint8_t index = usb_rx_byte();
+
+	while (n < RADIO_PROFILE_NAME_SIZE) {
+		name[n++] = usb_rx_byte();
+	}
+
+	// Save profile and tell master which one was saved
+	usb_tx_byte(radio_profile_save(index, name));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_PROFILE_ERASE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_profile_erase(void) {
+
+	// Read profile index
+	uint8_t index = usb_rx_byte();
+
+	// Erase profile and tell master which one was erased
+	usb_tx_byte(radio_profile_erase(index));
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    COMMAND_PROFILE_GET
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void command_profile_get(void) {
+
+	// Read profile index and get profile
+	struct radio_profile *profile = radio_profile(usb_rx_byte());
+
+	// If none
+	if (!profile) {
+
+		// Tell master
+		usb_tx_byte(RADIO_PROFILE_NONE);
+	}
+
+	// Otherwise
+	else {
+
+		// Send profile name and values to master
+		usb_tx_bytes((uint8_t *) profile, sizeof(struct radio_profile));
+	}
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     COMMAND_LED_TOGGLE
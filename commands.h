@@ -4,14 +4,42 @@
 #include "led.h"
 #include "usb.h"
 #include "radio.h"
+#include "history.h"
 
 uint8_t command_get(void);
 void command_do(uint8_t cmd);
+void command_framing(void);
 void command_register_read(void);
 void command_register_write(void);
+void command_registers_read(void);
+void command_registers_write(void);
+void command_registers_write_list(void);
+void command_radio_options(void);
+void command_radio_stats(void);
+void command_radio_packet(void);
+void command_radio_calibrate(void);
+void command_radio_locale(void);
 void command_radio_receive(void);
 void command_radio_send(void);
 void command_radio_send_receive(void);
+void command_radio_stage(void);
+void command_radio_flip_send_receive(void);
+void command_radio_exchange(uint8_t staged);
+void command_radio_burst(void);
+void command_radio_send_listen(void);
+void command_radio_send_at(void);
+void command_radio_stream(void);
+void command_radio_detect_locale(void);
+void command_radio_crc(void);
+void command_radio_filter(void);
+void command_history_download(void);
+void command_template_save(void);
+void command_template_send(void);
+void command_time(void);
+void command_profile_apply(void);
+void command_profile_save(void);
+void command_profile_erase(void);
+void command_profile_get(void);
 void command_led_toggle(void);
 void command_led_on(void);
 void command_led_off(void);
@@ -0,0 +1,87 @@
+#include "dma.h"
+
+// Generate DMA descriptors (channel 0 on its own, channels 1 to 4 in a row)
+__xdata static struct cc_dma_channel dma_channels[DMA_CHANNELS];
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    DMA_INIT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void dma_init(void) {
+
+    // Abort all channels
+    DMAARM = DMAARM_ABORT | 0x1F;
+
+    // Tell DMA controller where descriptors are
+    SET_WORD(DMA0CFG, &dma_channels[0]);
+    SET_WORD(DMA1CFG, &dma_channels[1]);
+
+    // Reset interrupt flags
+    DMAIRQ = 0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    DMA_CONFIGURE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Fill descriptor of given channel. Length may carry VLEN bits in its high
+    byte. Channel must not be armed.
+*/
+void dma_configure(uint8_t channel, uint16_t src, uint16_t dst, uint16_t len,
+                   uint8_t cfg0, uint8_t cfg1) {
+
+    // Get descriptor
+    __xdata struct cc_dma_channel *dma = &dma_channels[channel];
+
+    // Fill it
+    dma->src_high = src >> 8;
+    dma->src_low = src & 0xFF;
+    dma->dst_high = dst >> 8;
+    dma->dst_low = dst & 0xFF;
+    dma->len_high = len >> 8;
+    dma->len_low = len & 0xFF;
+    dma->cfg0 = cfg0;
+    dma->cfg1 = cfg1;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    DMA_ARM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Note: channel needs 9 cycles to load its descriptor before it can react to
+    a trigger.
+*/
+void dma_arm(uint8_t channel) {
+
+    // Arm channel
+    DMAARM |= 1 << channel;
+
+    // Wait until descriptor is loaded
+    NOP(); NOP(); NOP();
+    NOP(); NOP(); NOP();
+    NOP(); NOP(); NOP();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    DMA_ABORT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void dma_abort(uint8_t channel) {
+
+    // Disarm channel
+    DMAARM = DMAARM_ABORT | (1 << channel);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    DMA_TRIGGER
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Start transfer of armed channel by software.
+*/
+void dma_trigger(uint8_t channel) {
+
+    // Request transfer
+    DMAREQ |= 1 << channel;
+}
\ No newline at end of file
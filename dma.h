@@ -0,0 +1,23 @@
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include "cc1111.h"
+#include "lib.h"
+
+// DMA channels
+#define DMA_CHANNEL_RADIO 0
+#define DMA_CHANNEL_FLASH 1
+#define DMA_CHANNELS      5
+
+// DMA channel masks
+#define DMA_MASK_RADIO (1 << DMA_CHANNEL_RADIO)
+#define DMA_MASK_FLASH (1 << DMA_CHANNEL_FLASH)
+
+void dma_init(void);
+void dma_configure(uint8_t channel, uint16_t src, uint16_t dst, uint16_t len,
+                   uint8_t cfg0, uint8_t cfg1);
+void dma_arm(uint8_t channel);
+void dma_abort(uint8_t channel);
+void dma_trigger(uint8_t channel);
+
+#endif
\ No newline at end of file
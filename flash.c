@@ -0,0 +1,95 @@
+#include "flash.h"
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    FLASH_INIT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void flash_init(void) {
+
+    // Set write timing
+    FWT = FLASH_FWT;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    FLASH_WAIT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void flash_wait(void) {
+
+    // Wait until flash controller is done
+    while (FCTL & FCTL_BUSY) {
+        NOP();
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    FLASH_ERASE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Set all bytes of given page to 0xFF. CPU is halted meanwhile (~20 ms),
+    since it runs from flash.
+*/
+void flash_erase(uint8_t page) {
+
+    // Wait until flash controller is ready
+    flash_wait();
+
+    // Select page
+    FADDRH = page << 1;
+    FADDRL = 0;
+
+    // Erase it
+    FCTL |= FCTL_ERASE;
+    NOP();
+
+    // Wait until it is done
+    flash_wait();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    FLASH_WRITE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Write bytes to (erased) flash at given address, both even, using DMA: the
+    flash controller asks for every byte it needs.
+*/
+void flash_write(uint16_t addr, __xdata uint8_t *bytes, uint16_t size) {
+
+    // Wait until flash controller is ready
+    flash_wait();
+
+    // Move bytes from buffer to flash controller
+    dma_configure(DMA_CHANNEL_FLASH,
+                  (uint16_t) bytes,
+                  (uint16_t) &FWDATAXADDR,
+                  size,
+                  DMA_CFG0_WORDSIZE_8 | DMA_CFG0_TMODE_SINGLE |
+                  DMA_CFG0_TRIGGER_FLASH,
+                  DMA_CFG1_SRCINC_1 | DMA_CFG1_DESTINC_0 |
+                  DMA_CFG1_PRIORITY_HIGH);
+
+    // Reset DMA interrupt flag
+    DMAIRQ &= ~DMA_MASK_FLASH;
+
+    // Set address (in words)
+    SET_WORD(FADDR, addr >> 1);
+
+    // Arm DMA
+    dma_arm(DMA_CHANNEL_FLASH);
+
+    // Start writing
+    FCTL |= FCTL_WRITE;
+
+    // Wait until DMA gave all bytes
+    while (!(DMAIRQ & DMA_MASK_FLASH)) {
+        NOP();
+    }
+
+    // Wait until last ones are written
+    flash_wait();
+
+    // Reset DMA interrupt flag
+    DMAIRQ &= ~DMA_MASK_FLASH;
+}
\ No newline at end of file
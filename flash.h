@@ -0,0 +1,26 @@
+#ifndef _FLASH_H_
+#define _FLASH_H_
+
+#include "cc1111.h"
+#include "lib.h"
+#include "dma.h"
+
+// Flash pages
+#define FLASH_PAGE_SIZE 1024
+#define FLASH_PAGES     32
+
+// Flash pages kept for data (code must end before first one, see Makefile)
+#define FLASH_PAGE_PROFILES 30
+
+// Flash write timing (for 24 MHz clock)
+#define FLASH_FWT 0x20
+
+// Erased flash byte
+#define FLASH_EMPTY 0xFF
+
+void flash_init(void);
+void flash_wait(void);
+void flash_erase(uint8_t page);
+void flash_write(uint16_t addr, __xdata uint8_t *bytes, uint16_t size);
+
+#endif
\ No newline at end of file
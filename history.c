@@ -0,0 +1,242 @@
+#include "history.h"
+
+// Generate page and reply buffers
+__xdata static uint8_t history_page[MEDTRONIC_PAGE_SIZE];
+__xdata static uint8_t history_message[HISTORY_REPLY_SIZE];
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    HISTORY_REPLY
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Put reply of given type (ACK or NAK) to pump in TX buffer. Its address was
+    taken from a frame already.
+*/
+void history_reply(uint8_t type) {
+
+    // Write message type and zero byte after address
+    history_message[MEDTRONIC_TYPE_INDEX] = type;
+    history_message[MEDTRONIC_TYPE_INDEX + 1] = 0;
+
+    // End message with its CRC
+    history_message[HISTORY_REPLY_SIZE - 1] =
+        medtronic_crc8(history_message, HISTORY_REPLY_SIZE - 1);
+
+    // Fill TX buffer with it
+    radio_tx_load(history_message, HISTORY_REPLY_SIZE);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    HISTORY_SEND
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send TX buffer on given channel (page request, or last reply).
+*/
+void history_send(uint8_t channel) {
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Send bytes from TX buffer
+    radio_transmit();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    HISTORY_DOWNLOAD
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send page request given by master, then receive every frame of page (each
+    within timeout in ms), ACK them, and send master the page assembled, then
+    return whether its CRC16 is right. Frames already received (ACK lost) are
+    ACKed again and dropped; frames coming out of order, or broken, are NAKed
+    so that pump sends them again. Without an answer, the request or last reply
+    is sent again, as many times as retries allow (counted again from each new
+    frame). Request is given decoded: 4b6b encoding and decoding are turned
+    on meanwhile (as frames may hold any byte, page needs length framing),
+    and RX cut-through off. Frames broken or out of order until no retries
+    are left give a CRC error.
+*/
+uint8_t history_download(uint8_t tx_channel, uint8_t rx_channel,
+                         uint32_t timeout, uint8_t retries) {
+
+    // Initialize frame bytes, their number, and frame number
+    __xdata uint8_t *bytes;
+    uint8_t size;
+    uint8_t frame;
+
+    // Initialize frame expected, retry count, error and whether page is done
+    uint8_t expected = 1;
+    uint8_t retry = retries;
+    uint8_t error = 0;
+    uint8_t done = 0;
+
+    // Initialize page size and byte index
+    uint16_t n = 0;
+    uint16_t i = 0;
+
+    // Remember options
+    uint8_t options = radio_get_options();
+
+    // If page can't be sent to master
+    if (radio_get_framing() != USB_FRAMING_LENGTH) {
+
+        // Read request anyway, so that it isn't taken for commands
+        radio_tx_begin();
+
+        while (!radio_tx_fill(1)) {
+            NOP();
+        }
+
+        // Tell master
+        return RADIO_ERROR_FRAMING;
+    }
+
+    // Exchange decoded bytes, and keep received ones away from master
+    radio_set_options((options | RADIO_OPTION_DECODE | RADIO_OPTION_ENCODE) &
+                      ~RADIO_OPTION_RX_CUT_THROUGH);
+
+    // Send page request
+    radio_send(tx_channel, 0, 0);
+
+    // Loop until page is done, or given up
+    while (!done) {
+
+        // Wait for frame
+        error = radio_rx_wait(rx_channel, timeout);
+
+        // If none
+        if (error == RADIO_ERROR_TIMEOUT && retry > 0) {
+
+            // Send request or last reply again
+            history_send(tx_channel);
+            retry--;
+
+            // Wait again
+            continue;
+        }
+
+        // If stopped
+        if (error != 0) {
+
+            // Give up
+            break;
+        }
+
+        // Get frame
+        bytes = radio_rx_take(&size);
+        frame = bytes[MEDTRONIC_FRAME_INDEX] & ~MEDTRONIC_FRAME_LAST;
+
+        // If broken
+        if (size != MEDTRONIC_FRAME_MESSAGE ||
+            medtronic_crc8(bytes, size - 1) != bytes[size - 1]) {
+
+            // Not a frame
+            frame = 0;
+        }
+
+        // If expected
+        if (frame == expected) {
+
+            // Take pump address from it
+            i = 0;
+
+            while (i < MEDTRONIC_ADDRESS_SIZE) {
+                history_message[i] = bytes[i];
+                i++;
+            }
+
+            // Add its bytes to page
+            i = 0;
+
+            while (i < MEDTRONIC_FRAME_SIZE) {
+                history_page[n++] = bytes[MEDTRONIC_FRAME_INDEX + 1 + i++];
+            }
+
+            // Page done after last frame
+            done = (bytes[MEDTRONIC_FRAME_INDEX] & MEDTRONIC_FRAME_LAST) ||
+                   expected == MEDTRONIC_FRAMES;
+
+            // Track frequency offset on it
+            radio_rx_passed();
+
+            // Expect next one, with all retries
+            expected++;
+            retry = retries;
+
+            // ACK it
+            history_reply(MEDTRONIC_ACK);
+        }
+
+        // If no retries left
+        else if (retry == 0) {
+
+            // Give up (frames came, but none right)
+            error = RADIO_ERROR_CRC;
+        }
+
+        // Otherwise
+        else {
+
+            // One less retry
+            retry--;
+
+            // If already received, ACK it again
+            if (frame != 0 && frame < expected) {
+                history_reply(MEDTRONIC_ACK);
+            }
+
+            // If broken, or frames missed, ask for expected one again
+            // (unless pump address unknown yet: then request is sent again)
+            else if (expected > 1) {
+                history_reply(MEDTRONIC_NAK);
+            }
+        }
+
+        // Free slot
+        radio_rx_free();
+
+        // If given up
+        if (error != 0) {
+
+            // Exit
+            break;
+        }
+
+        // Send reply (or request again)
+        history_send(tx_channel);
+    }
+
+    // Put radio back in idle state
+    radio_rx_stop();
+
+    // Restore options
+    radio_set_options(options);
+
+    // If page not done
+    if (!done) {
+
+        // Return error
+        return error;
+    }
+
+    // Send page to master
+    usb_put_length(n);
+
+    i = 0;
+
+    while (i < n) {
+        usb_put_byte(history_page[i++]);
+    }
+
+    usb_flush_bytes();
+
+    // Return whether CRC16 ending page is right
+    if (n < 2 || medtronic_crc16(MEDTRONIC_CRC16_INIT, history_page, n - 2) !=
+        (((uint16_t) history_page[n - 2] << 8) | history_page[n - 1])) {
+        return RADIO_ERROR_CRC;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include "cc1111.h"
+#include "lib.h"
+#include "usb.h"
+#include "radio.h"
+#include "medtronic.h"
+
+// Reply to frames (ACK or NAK): address, message type, zero byte and CRC8
+#define HISTORY_REPLY_SIZE (MEDTRONIC_ADDRESS_SIZE + 3)
+
+void history_reply(uint8_t type);
+void history_send(uint8_t channel);
+uint8_t history_download(uint8_t tx_channel, uint8_t rx_channel,
+                         uint32_t timeout, uint8_t retries);
+
+#endif
\ No newline at end of file
@@ -11,6 +11,8 @@ void main(void) {
     clock_init();
     timer_init();
     led_init();
+    dma_init();
+    flash_init();
     usb_init();
     radio_init();
 
@@ -4,6 +4,8 @@
 #include "clock.h"
 #include "timer.h"
 #include "led.h"
+#include "dma.h"
+#include "flash.h"
 #include "usb.h"
 #include "radio.h"
 #include "commands.h"
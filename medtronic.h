@@ -0,0 +1,39 @@
+#ifndef _MEDTRONIC_H_
+#define _MEDTRONIC_H_
+
+#include "cc1111.h"
+#include "lib.h"
+
+// 4b6b symbols: invalid one, and zero one ending packets on air
+#define MEDTRONIC_SYMBOL_INVALID 0xFF
+#define MEDTRONIC_SYMBOL_END     0x00
+
+// CRC16 initial value
+#define MEDTRONIC_CRC16_INIT 0xFFFF
+
+// Messages: packet type and pump serial (address), message type, then bytes
+// and CRC8
+#define MEDTRONIC_ADDRESS_SIZE 4
+#define MEDTRONIC_TYPE_INDEX   4
+#define MEDTRONIC_ACK          0x06
+#define MEDTRONIC_NAK          0x15
+
+// History page frames: number (last one flagged) after message type, then
+// bytes (last 2 bytes of page: CRC16)
+#define MEDTRONIC_FRAME_INDEX   5
+#define MEDTRONIC_FRAME_LAST    (1 << 7)
+#define MEDTRONIC_FRAME_SIZE    64
+#define MEDTRONIC_FRAME_MESSAGE (MEDTRONIC_FRAME_INDEX + 1 + \
+                                 MEDTRONIC_FRAME_SIZE + 1)
+#define MEDTRONIC_FRAMES        16
+#define MEDTRONIC_PAGE_SIZE     (MEDTRONIC_FRAMES * MEDTRONIC_FRAME_SIZE)
+
+uint16_t medtronic_encode_byte(uint8_t byte, uint8_t mask);
+uint8_t medtronic_encode(__xdata uint8_t *bytes, uint8_t size,
+                         uint8_t mask);
+uint8_t medtronic_decode(__xdata uint8_t *bytes, uint8_t size,
+                         uint8_t *errors);
+uint8_t medtronic_crc8(__xdata uint8_t *bytes, uint8_t size);
+uint16_t medtronic_crc16(uint16_t crc, __xdata uint8_t *bytes, uint16_t size);
+
+#endif
\ No newline at end of file
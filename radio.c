@@ -1,22 +1,183 @@
 #include "radio.h"
 
 // Generate data buffers
-__xdata static uint8_t radio_rx_buffer[RADIO_MAX_PACKET_SIZE] = {0};
-__xdata static uint8_t radio_tx_buffer[RADIO_MAX_PACKET_SIZE] = {0};
+__xdata static uint8_t radio_rx_ring[RADIO_RX_SLOTS][RADIO_MAX_PACKET_SIZE];
+__xdata static uint8_t radio_tx_buffers[2][RADIO_MAX_PACKET_SIZE];
+
+// Initialize RX buffer (ring slot currently filled by DMA)
+static __xdata uint8_t *radio_rx_buffer = radio_rx_ring[0];
+
+// Initialize TX buffer (filled and sent), and staged one (next to be sent)
+static __xdata uint8_t *radio_tx_buffer = radio_tx_buffers[0];
+static __xdata uint8_t *radio_tx_staged = radio_tx_buffers[1];
 
 // Initialize data buffer sizes
-static uint8_t radio_rx_buffer_size = 0;
+volatile static uint8_t radio_rx_buffer_size = 0;
 static uint8_t radio_tx_buffer_size = 0;
+static uint8_t radio_tx_staged_size = 0;
+
+// Initialize whether master may stage next packet while radio listens
+static uint8_t radio_tx_staging = 0;
+
+// Initialize RX ring slots: being filled, next to be read, and complete ones
+volatile static uint8_t radio_rx_head = 0;
+volatile static uint8_t radio_rx_tail = 0;
+volatile static uint8_t radio_rx_count = 0;
+
+// Generate sizes of complete RX ring slots
+__xdata static uint8_t radio_rx_sizes[RADIO_RX_SLOTS];
+
+// Generate frequency offset estimates of complete RX ring slots
+__xdata static int8_t radio_rx_freqests[RADIO_RX_SLOTS];
+
+// Initialize RX header size (depends on options)
+static uint8_t radio_rx_header = RADIO_HEADER_SIZE;
+
+// Initialize where RX metadata goes in header
+static uint8_t radio_rx_meta = RADIO_HEADER_SIZE;
 
-// Initialize data buffer index
-static uint8_t radio_tx_buffer_index = 0;
+// Initialize number of bytes of RX buffer known to be written
+static uint8_t radio_rx_scan = RADIO_HEADER_SIZE;
 
-// Initialize writing underflow count
-static uint8_t radio_tx_underflow_count = 0;
+// Initialize whether packet in head slot is known to pass address filter
+static uint8_t radio_rx_matched = 0;
+
+// Initialize number of bytes of oldest RX ring slot already sent to master
+static uint8_t radio_rx_sent = 0;
+
+// Initialize number of bytes of TX packet still expected from master
+static uint16_t radio_tx_left = 0;
+
+// Initialize RX ring state and channel
+volatile static uint8_t radio_rx_open = 0;
+static uint8_t radio_rx_channel = 0;
 
 // Initialize packet count
 static uint8_t radio_packet_count = 0;
 
+// Generate register table (address given by master is index)
+static __xdata uint8_t * __code radio_registers[RADIO_REGISTERS] = {
+    &SYNC1,     // 0
+    &SYNC0,     // 1
+    &PKTLEN,    // 2
+    &PKTCTRL1,  // 3
+    &PKTCTRL0,  // 4
+    &ADDR,      // 5
+    &FSCTRL1,   // 6
+    &FSCTRL0,   // 7
+    &MDMCFG4,   // 8
+    &MDMCFG3,   // 9
+    &MDMCFG2,   // 10
+    &MDMCFG1,   // 11
+    &MDMCFG0,   // 12
+    &DEVIATN,   // 13
+    &MCSM2,     // 14
+    &MCSM1,     // 15
+    &MCSM0,     // 16
+    &BSCFG,     // 17
+    &FOCCFG,    // 18
+    &FREND1,    // 19
+    &FREND0,    // 20
+    &FSCAL3,    // 21
+    &FSCAL2,    // 22
+    &FSCAL1,    // 23
+    &FSCAL0,    // 24
+    &TEST1,     // 25
+    &TEST0,     // 26
+    &PA_TABLE1, // 27
+    &PA_TABLE0, // 28
+    &AGCCTRL2,  // 29
+    &AGCCTRL1,  // 30
+    &AGCCTRL0,  // 31
+    &FREQ2,     // 32
+    &FREQ1,     // 33
+    &FREQ0,     // 34
+    &CHANNR,    // 35
+};
+
+// Generate built-in profiles
+__code static struct radio_profile radio_profiles[RADIO_PROFILES_BUILTIN] = {
+
+    // North America (NA)
+    // Base frequency: f = 916.541 MHz
+    // Effective frequency: f' = 916.541 MHz
+    {
+        {'N', 'A'},
+        {
+            0xFF, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x06, 0x00, // SYNC1 - FSCTRL0
+            0x99, 0x66, 0x33, 0x61, 0x7E, 0x15, 0x07, 0x30, // MDMCFG4 - MCSM1
+            0x18, 0x6C, 0x17, 0xB6, 0x11, 0xE9, 0x2A, 0x00, // MCSM0 - FSCAL1
+            0x1F, 0x31, 0x09, 0xC0, 0x00, 0x07, 0x00, 0x91, // FSCAL0 - AGCCTRL0
+            0x26, 0x30, 0x70, 0x00                          // FREQ2 - CHANNR
+        }
+    },
+
+    // Worldwide (WW)
+    // Base frequency: f = 868.333 MHz
+    // Effective frequency: f' = 868.333 MHz
+    {
+        {'W', 'W'},
+        {
+            0xFF, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x06, 0x00, // SYNC1 - FSCTRL0
+            0x99, 0x66, 0x33, 0x61, 0x7E, 0x15, 0x07, 0x30, // MDMCFG4 - MCSM1
+            0x18, 0x6C, 0x17, 0xB6, 0x11, 0xE9, 0x2A, 0x00, // MCSM0 - FSCAL1
+            0x1F, 0x31, 0x09, 0xC2, 0x00, 0x07, 0x00, 0x91, // FSCAL0 - AGCCTRL0
+            0x24, 0x2E, 0x38, 0x00                          // FREQ2 - CHANNR
+        }
+    }
+};
+
+// Get user profiles (in flash)
+#define radio_user_profiles \
+    ((__code struct radio_profile *) RADIO_PROFILES_ADDR)
+
+// Generate buffer for user profiles (flash page is erased to change them)
+__xdata static struct radio_profile radio_profiles_buffer[RADIO_PROFILES_USER];
+
+// Generate locales (precomputed band settings)
+__code static struct radio_locale radio_locales[RADIO_LOCALES] = {
+
+    // North America (NA)
+    // Base frequency: f = 916.541 MHz
+    {0x26, 0x30, 0x70, 0xC0},
+
+    // Worldwide (WW)
+    // Base frequency: f = 868.333 MHz
+    {0x24, 0x2E, 0x38, 0xC2}
+};
+
+// Initialize current locale
+static uint8_t radio_locale = RADIO_LOCALE;
+
+// Generate channel calibrations of each locale, and initialize which ones are
+// known
+__xdata static struct radio_cal radio_cals[RADIO_LOCALES][RADIO_CAL_CHANNELS];
+static uint16_t radio_cals_valid[RADIO_LOCALES] = {0};
+
+// Generate frequency offset corrections of each locale's channels (1/16 steps
+// of FSCTRL0), and initialize FSCTRL0 they are added to, and the one applied
+__xdata static int16_t radio_afcs[RADIO_LOCALES][RADIO_CAL_CHANNELS];
+static uint8_t radio_afc_base = 0;
+static int8_t radio_afc = 0;
+
+// Initialize options, framing and packet mode
+static uint8_t radio_options = 0;
+static uint8_t radio_framing = USB_FRAMING_ZERO;
+static uint8_t radio_packet = RADIO_PACKET_SOFTWARE;
+static uint8_t radio_packet_length = 0;
+
+// Initialize CRC policy
+static uint8_t radio_crc = RADIO_CRC_CHECK_NONE;
+
+// Generate statistics
+__xdata static struct radio_stats radio_stats = {0, 0, 0xFF, 0};
+
+// Generate address filter (off)
+__xdata static struct radio_filter radio_filter;
+
+// Generate TX templates (empty)
+__xdata static struct radio_template radio_templates[RADIO_TEMPLATES];
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     RADIO_INIT
@@ -42,11 +203,14 @@ void radio_enable_interrupts(void) {
     RFIM = RFIM_IM_TXUNF | RFIM_IM_RXOVF | RFIM_IM_TIMEOUT | RFIM_IM_DONE |
            RFIM_IM_CS | RFIM_IM_PQT | RFIM_IM_CCA | RFIM_IM_SFD;
 
-    // Enable RF interrupts
-    RFTXRXIE = 1;
+    // Bytes are moved by DMA: no RF TX/RX interrupts
+    RFTXRXIE = 0;
 
     // Enable interrupts
     IEN2 |= IEN2_RFIE;
+
+    // Enable DMA interrupts (RX end of buffer)
+    IEN1 |= IEN1_DMAIE;
 }
 
 /*
@@ -72,6 +236,9 @@ void radio_state_idle(void) {
     // Go in idle state
     RFST = RFST_SIDLE;
 
+    // Stop moving bytes between radio and buffers
+    dma_abort(DMA_CHANNEL_RADIO);
+
     // Wait until radio is in idle state
     radio_state_wait_idle();
 }
@@ -126,476 +293,2923 @@ void radio_state_transmit(void) {
 */
 void radio_configure(void) {
 
-    // Configure radio
-    SYNC1     = 0xFF;
-    SYNC0     = 0x00;
-    PKTLEN    = 0xFF;
-    PKTCTRL1  = 0x00;
-    PKTCTRL0  = 0x00;
-    ADDR      = 0x00;
-    FSCTRL1   = 0x06;
-    FSCTRL0   = 0x00;
-    MDMCFG4   = 0x99;
-    MDMCFG3   = 0x66;
-    MDMCFG2   = 0x33;
-    MDMCFG1   = 0x61;
-    MDMCFG0   = 0x7E; // Channel bandwidth: 69.946 kHz
-    DEVIATN   = 0x15;
-    MCSM2     = 0x07;
-    MCSM1     = 0x30;
-    MCSM0     = 0x18;
-    FOCCFG    = 0x17;
-    FREND1    = 0xB6;
-    FREND0    = 0x11;
-    FSCAL3    = 0xE9;
-    FSCAL2    = 0x2A;
-    FSCAL1    = 0x00;
-    FSCAL0    = 0x1F;
-    TEST1     = 0x31;
-    TEST0     = 0x09;
-    PA_TABLE0 = 0x00;
-    AGCCTRL2  = 0x07;
-    AGCCTRL1  = 0x00;
-    AGCCTRL0  = 0x91;
-
-    // Radio locale
-    // North America (NA)
-    // Base frequency: f = 916.541 MHz
-    // Effective frequency: f' = 916.541 MHz
-    #if RADIO_LOCALE == RADIO_LOCALE_NA
-        FREQ2     = 0x26;
-        FREQ1     = 0x30;
-        FREQ0     = 0x70;
-        CHANNR    = 0x00;
-        PA_TABLE1 = 0xC0;
-
-    // Worldwide (WW)
-    // Base frequency: f = 868.333 MHz
-    // Effective frequency: f' = 868.333 MHz
-    #elif RADIO_LOCALE == RADIO_LOCALE_WW
-        FREQ2     = 0x24;
-        FREQ1     = 0x2E;
-        FREQ0     = 0x38;
-        CHANNR    = 0x00;
-        PA_TABLE1 = 0xC2;
-    #endif
+    // Apply built-in profile of startup locale
+    radio_apply(radio_profiles[RADIO_LOCALE].values);
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     RADIO_REGISTER
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Get register from its address as given by master (0 if unknown).
 */
 uint8_t * radio_register(uint8_t addr) {
 
-    // Initialize register pointer
-    uint8_t *reg = 0;
+    // If address unknown
+    if (addr >= RADIO_REGISTERS) {
 
-    // Assign pointer
-    switch (addr) {
-        case 0:
-            reg = &SYNC1;
-            break;
-        case 1:
-            reg = &SYNC0;
-            break;
-        case 2:
-            reg = &PKTLEN;
-            break;
-        case 3:
-            reg = &PKTCTRL1;
-            break;
-        case 4:
-            reg = &PKTCTRL0;
-            break;
-        case 5:
-            reg = &ADDR;
-            break;
-        case 6:
-            reg = &FSCTRL1;
-            break;
-        case 7:
-            reg = &FSCTRL0;
-            break;
-        case 8:
-            reg = &MDMCFG4;
-            break;
-        case 9:
-            reg = &MDMCFG3;
-            break;
-        case 10:
-            reg = &MDMCFG2;
-            break;
-        case 11:
-            reg = &MDMCFG1;
-            break;
-        case 12:
-            reg = &MDMCFG0;
-            break;
-        case 13:
-            reg = &DEVIATN;
-            break;
-        case 14:
-            reg = &MCSM2;
-            break;
-        case 15:
-            reg = &MCSM1;
-            break;
-        case 16:
-            reg = &MCSM0;
-            break;
-        case 17:
-            reg = &BSCFG;
-            break;
-        case 18:
-            reg = &FOCCFG;
-            break;
-        case 19:
-            reg = &FREND1;
-            break;
-        case 20:
-            reg = &FREND0;
-            break;
-        case 21:
-            reg = &FSCAL3;
-            break;
-        case 22:
-            reg = &FSCAL2;
-            break;
-        case 23:
-            reg = &FSCAL1;
-            break;
-        case 24:
-            reg = &FSCAL0;
-            break;
-        case 25:
-            reg = &TEST1;
-            break;
-        case 26:
-            reg = &TEST0;
-            break;
-        case 27:
-            reg = &PA_TABLE1;
-            break;
-        case 28:
-            reg = &PA_TABLE0;
-            break;
-        case 29:
-            reg = &AGCCTRL2;
-            break;
-        case 30:
-            reg = &AGCCTRL1;
-            break;
-        case 31:
-            reg = &AGCCTRL0;
-            break;
-        case 32:
-            reg = &FREQ2;
-            break;
-        case 33:
-            reg = &FREQ1;
-            break;
-        case 34:
-            reg = &FREQ0;
-            break;
-        case 35:
-            reg = &CHANNR;
-            break;
+        // No register
+        return 0;
     }
 
     // Return register pointer
-    return reg;
+    return radio_registers[addr];
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    RADIO_RECEIVE
+    RADIO_APPLY
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    Timeout input given in s.
+    Write all registers at once (values in order of their addresses), with
+    radio idle. Packet mode and options set by master are kept.
 */
-uint8_t radio_receive(uint8_t channel, uint32_t timeout) {
+void radio_apply(uint8_t *values) {
 
-    // Initialize byte count, and error
-    uint8_t n = 0;
-    uint8_t error = 0;
-
-    // Initialize byte
-    int byte = 0;
+    // Initialize register address
+    uint8_t addr = 0;
 
     // Put radio in idle state
-    radio_state_idle();
+    radio_rx_stop();
 
-    // Set channel
-    CHANNR = channel;
+    // Write registers
+    while (addr < RADIO_REGISTERS) {
+        *radio_registers[addr] = values[addr];
+        addr++;
+    }
 
-    // Reset buffer size
-    radio_rx_buffer_size = 0;
+    // Forget channel calibrations made with other settings
+    radio_cal_clear();
 
-    // Put radio in receive state
-    radio_state_receive();
+    // Keep packet mode and options
+    radio_set_packet(radio_packet, radio_packet_length);
+    radio_set_options(radio_options);
+}
 
-    // Reset timer counter
-    timer_counter_reset();
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_PROFILE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Get profile from its index (0 if unknown or empty).
+*/
+struct radio_profile * radio_profile(uint8_t index) {
 
-    // Loop parallel to RF ISRs and react when new bytes are received
-    while (1) {
+    // If built-in profile
+    if (index < RADIO_PROFILES_BUILTIN) {
 
-        // If new unread byte(s)
-        if (radio_rx_buffer_size > n) {
+        // Return it
+        return (struct radio_profile *) &radio_profiles[index];
+    }
 
-            // Check for absence of data
-            if (n == 0 && radio_rx_buffer_size > 2 && radio_rx_buffer[2] == 0) {
+    // Get user profile index
+    index -= RADIO_PROFILES_BUILTIN;
 
-                // Assign no data error
-                error = RADIO_ERROR_NO_DATA;
+    // If user profile stored
+    if (index < RADIO_PROFILES_USER &&
+        radio_user_profiles[index].name[0] != FLASH_EMPTY) {
 
-                // Exit
-                break;
-            }
+        // Return it
+        return (struct radio_profile *) &radio_user_profiles[index];
+    }
 
-            // Read current byte
-            byte = radio_rx_buffer[n];
+    // No profile
+    return 0;
+}
 
-            // Update byte count
-            n++;
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_PROFILE_APPLY
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Apply given profile and return its index, or RADIO_PROFILE_NONE if there
+    is none.
+*/
+uint8_t radio_profile_apply(uint8_t index) {
 
-            // If end of packet
-            if (n > 2 && n == radio_rx_buffer_size && byte == 0) {
+    // Get profile
+    struct radio_profile *profile = radio_profile(index);
 
-                // Exit
-                break;
-            }
-        }
+    // If none
+    if (!profile) {
 
-        // If no bytes received
-        else if (radio_rx_buffer_size == 0) {
+        // Nothing applied
+        return RADIO_PROFILE_NONE;
+    }
 
-            // If timeout given and expired
-            if (timeout > 0 && timer_counter > timeout) {
+    // Apply it
+    radio_apply(profile->values);
 
-                // Assign timeout error
-                error = RADIO_ERROR_TIMEOUT;
+    // Return its index
+    return index;
+}
 
-                // Exit
-                break;
-            }
-        }
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_PROFILES_LOAD
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Copy user profiles from flash to buffer, before changing them.
+*/
+void radio_profiles_load(void) {
 
-        // If interruption requested
-        if (usb_poll_byte() != -1) {
+    // Get bytes
+    __code uint8_t *src = (__code uint8_t *) RADIO_PROFILES_ADDR;
+    __xdata uint8_t *dst = (__xdata uint8_t *) radio_profiles_buffer;
 
-            // Assign error
-            error = RADIO_ERROR_INTERRUPTED;
+    // Initialize byte count
+    uint16_t n = sizeof(radio_profiles_buffer);
 
-            // Exit
-            break;
-        }
+    // Copy them
+    while (n--) {
+        *dst++ = *src++;
     }
+}
 
-    // Put radio back in idle state
-    radio_state_idle();
-
-    // If no error
-    if (error == 0) {
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_PROFILES_STORE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Replace user profiles in flash with buffer. Radio must be idle.
+*/
+void radio_profiles_store(void) {
 
-        // Send bytes to master
-        usb_tx_bytes(radio_rx_buffer, radio_rx_buffer_size);
-    }
+    // Erase flash page
+    flash_erase(FLASH_PAGE_PROFILES);
 
-    // Return error
-    return error;
+    // Write profiles
+    flash_write(RADIO_PROFILES_ADDR, (__xdata uint8_t *) radio_profiles_buffer,
+                sizeof(radio_profiles_buffer));
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    RADIO_SEND
+    RADIO_PROFILE_SAVE
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Store current register values as user profile with given index and name,
+    and return index, or RADIO_PROFILE_NONE if it is not a user one.
 */
-void radio_send(uint8_t channel, uint8_t repeat, uint32_t delay) {
+uint8_t radio_profile_save(uint8_t index, uint8_t *name) {
 
-    // Initialize byte to send
-    uint8_t byte = 0;
+    // Get user profile in buffer
+    __xdata struct radio_profile *profile;
 
-    // Put radio in idle state
-    radio_state_idle();
+    // Initialize byte index
+    uint8_t n = 0;
 
-    // Set channel
-    CHANNR = channel;
+    // If not a user profile
+    if (index < RADIO_PROFILES_BUILTIN ||
+        index >= RADIO_PROFILES_BUILTIN + RADIO_PROFILES_USER) {
 
-    // Reset buffer size and index as well as underflow count
-    radio_tx_buffer_size = 0;
-    radio_tx_buffer_index = 0;
-    radio_tx_underflow_count = 0;
+        // Nothing saved
+        return RADIO_PROFILE_NONE;
+    }
 
-    // Fill buffer
-    while (1) {
+    // Put radio in idle state
+    radio_rx_stop();
 
-        // If byte is not exceeding max packet length
-        if (radio_tx_buffer_size < RADIO_MAX_PACKET_SIZE) {
+    // Get user profiles
+    radio_profiles_load();
 
-            // Get byte
-            byte = usb_rx_byte();
-        }
+    // Fill profile
+    profile = &radio_profiles_buffer[index - RADIO_PROFILES_BUILTIN];
 
-        // Overflow
-        else {
+    while (n < RADIO_PROFILE_NAME_SIZE) {
+        profile->name[n] = name[n];
+        n++;
+    }
 
-            // End byte
-            byte = 0;
-        }
+    n = 0;
 
-        // Write byte in buffer and update its size
-        radio_tx_buffer[radio_tx_buffer_size++] = byte;
+    while (n < RADIO_REGISTERS) {
+        profile->values[n] = *radio_registers[n];
+        n++;
+    }
 
-        // If end-of-packet byte
-        if (byte == 0) {
+    // Store profiles
+    radio_profiles_store();
 
-            // Exit
-            break;
-        }
+    // Return index
+    return index;
+}
 
-    }
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_PROFILE_ERASE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Remove user profile with given index, and return index, or
+    RADIO_PROFILE_NONE if there is none.
+*/
+uint8_t radio_profile_erase(uint8_t index) {
 
-    // Put radio in transmit state
-    radio_state_transmit();
+    // Get user profile in buffer
+    __xdata uint8_t *profile;
 
-    // Wait until packet is transmitted
-    radio_state_wait_idle();
+    // Initialize byte index
+    uint8_t n = 0;
 
-    // If repeat
-    while (repeat > 0) {
+    // If no user profile
+    if (index < RADIO_PROFILES_BUILTIN || !radio_profile(index)) {
 
-        // If delay
-        if (delay > 0) {
+        // Nothing erased
+        return RADIO_PROFILE_NONE;
+    }
 
-            // Wait
-            timer_wait(delay);
-        }
+    // Put radio in idle state
+    radio_rx_stop();
 
-        // Resend bytes from TX buffer
-        radio_resend();
+    // Get user profiles
+    radio_profiles_load();
 
-        // Decrease repeat count
-        repeat--;
+    // Empty profile
+    profile = (__xdata uint8_t *)
+              &radio_profiles_buffer[index - RADIO_PROFILES_BUILTIN];
+
+    while (n < sizeof(struct radio_profile)) {
+        profile[n++] = FLASH_EMPTY;
     }
+
+    // Store profiles
+    radio_profiles_store();
+
+    // Return index
+    return index;
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    RADIO_RESEND
+    RADIO_SET_CHANNEL
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    When calibrations are cached, radio does not calibrate itself anymore: the
+    one of given channel is restored, or made once (~0.7 ms) and stored, so
+    that RX/TX start right away on it from then on. Radio must be idle.
 */
-void radio_resend(void) {
+void radio_set_channel(uint8_t channel) {
 
-    // Put radio in idle state
-    radio_state_idle();
+    // Set channel
+    CHANNR = channel;
 
-    // Reset buffer index as well as underflow count
-    radio_tx_buffer_index = 0;
-    radio_tx_underflow_count = 0;
+    // Apply its frequency offset correction
+    radio_afc_apply();
 
-    // Put radio in transmit state
-    radio_state_transmit();
+    // If radio calibrates itself
+    if (!(radio_options & RADIO_OPTION_CAL_CACHE)) {
 
-    // Wait until packet is transmitted
-    radio_state_wait_idle();
+        // Nothing else to do
+        return;
+    }
+
+    // If calibration known
+    if (channel < RADIO_CAL_CHANNELS && radio_locale != RADIO_LOCALE_NONE &&
+        (radio_cals_valid[radio_locale] & ((uint16_t) 1 << channel))) {
+
+        // Restore it
+        FSCAL3 = radio_cals[radio_locale][channel].fscal3;
+        FSCAL2 = radio_cals[radio_locale][channel].fscal2;
+        FSCAL1 = radio_cals[radio_locale][channel].fscal1;
+    }
+
+    // Otherwise
+    else {
+
+        // Make it
+        radio_cal_channel(channel);
+    }
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    RADIO_RFTXRX_ISR
+    RADIO_CAL_CHANNEL
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    ISRs either when a new byte is ready to be read from RFD (RX) or when a new
-    one can be written to it (TX).
+    Calibrate frequency synthesizer on given channel and store result if it can
+    be cached. Radio must be idle.
 */
-void radio_rftxrx_isr(void) __interrupt RFTXRX_VECTOR {
-
-    // Define byte to read/write
-    uint8_t byte = 0;
+void radio_cal_channel(uint8_t channel) {
 
-    // Check MARC state
-    switch (RF_MARCSTATE) {
-
-        // Receiving
-        case RF_MARCSTATE_RX:
-
-            // Read byte from radio
-            byte = RFD;
-
-            // New packet
-            if (radio_rx_buffer_size == 0) {
+    // Set channel
+    CHANNR = channel;
 
-                // New packet: update count and avoid end-of-packet due to byte
-                // overflow
-                radio_packet_count = max(radio_packet_count + 1, 1);
+    // Calibrate
+    RFST = RFST_SCAL;
 
-                // First byte: packet count
-                radio_rx_buffer[0] = radio_packet_count;
+    // Wait until calibration started, then done
+    while (RF_MARCSTATE == RF_MARCSTATE_IDLE) {
+        NOP();
+    }
 
-                // Second byte: received signal strength indication (RSSI)
-                // Minimum set to 1 to avoid end-of-packet zero
-                radio_rx_buffer[1] = max(RF_RSSI, 1);
+    radio_state_wait_idle();
 
-                // Update buffer size
-                radio_rx_buffer_size = 2;
-            }
+    // If calibration can be cached
+    if (channel < RADIO_CAL_CHANNELS && radio_locale != RADIO_LOCALE_NONE) {
 
-            // Packet incomplete
-            if (radio_rx_buffer_size < RADIO_MAX_PACKET_SIZE) {
+        // Store it
+        radio_cals[radio_locale][channel].fscal3 = FSCAL3;
+        radio_cals[radio_locale][channel].fscal2 = FSCAL2;
+        radio_cals[radio_locale][channel].fscal1 = FSCAL1;
 
-                // Fill buffer and update its size
-                radio_rx_buffer[radio_rx_buffer_size++] = byte;
-            }
+        // It is now known
+        radio_cals_valid[radio_locale] |= (uint16_t) 1 << channel;
+    }
+}
 
-            // Overflow
-            else {
-                NOP();
-            }
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_CAL_CLEAR
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Forget channel calibrations and frequency offset corrections of all locales
+    (e.g. after radio settings changed), and find out which locale band now
+    matches: calibrations are only cached for locales.
+*/
+void radio_cal_clear(void) {
 
-            // Exit
-            break;
+    // Initialize locale
+    uint8_t locale = 0;
 
-        // Transmitting
-        case RF_MARCSTATE_TX:
+    // Initialize channel
+    uint8_t channel;
 
-            // If new byte is ready to be sent
-            if (radio_tx_buffer_size > radio_tx_buffer_index) {
+    // No calibration or frequency offset correction known
+    while (locale < RADIO_LOCALES) {
+        radio_cals_valid[locale] = 0;
 
-                // Get byte and update index
-                byte = radio_tx_buffer[radio_tx_buffer_index++];
+        channel = 0;
 
-                // Give to radio
-                RFD = byte;
-            }
+        while (channel < RADIO_CAL_CHANNELS) {
+            radio_afcs[locale][channel++] = 0;
+        }
 
-            // Otherwise: underflow
-            else {
+        locale++;
+    }
 
-                // Tell radio no more bytes to send
-                RFD = 0;
+    // If master changed FSCTRL0, corrections now go on top of its value
+    if (FSCTRL0 != (uint8_t) (radio_afc_base + radio_afc)) {
+        radio_afc_base = FSCTRL0;
+        radio_afc = 0;
+    }
 
-                // Update underflow count
-                radio_tx_underflow_count++;
+    // Look for locale of band
+    radio_locale = RADIO_LOCALE_NONE;
 
-                // If underflow twice, radio should have sent all bytes
-                if (radio_tx_underflow_count == 2) {
+    while (locale--) {
 
-                    // Put radio back in idle state
-                    radio_state_idle();
-                }
-            }
+        // If band matches
+        if (FREQ2 == radio_locales[locale].freq2 &&
+            FREQ1 == radio_locales[locale].freq1 &&
+            FREQ0 == radio_locales[locale].freq0) {
 
-            // Exit
-            break;
+            // Store locale
+            radio_locale = locale;
+        }
     }
 }
 
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-    RADIO_GENERAL_ISR
+    RADIO_AFC_APPLY
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Add frequency offset correction of current channel to FSCTRL0 (none if AFC
+    is off, or channel can't be tracked), as far as its range goes. Radio must
+    be idle.
 */
-void radio_general_isr(void) __interrupt RF_VECTOR {
+void radio_afc_apply(void) {
+
+    // Initialize correction, and FSCTRL0 it leads to
+    int8_t afc = 0;
+    int16_t fsctrl0;
+
+    // If channel tracked
+    if ((radio_options & RADIO_OPTION_AFC) && CHANNR < RADIO_CAL_CHANNELS &&
+        radio_locale != RADIO_LOCALE_NONE) {
+
+        // Get its correction (rounded)
+        afc = (radio_afcs[radio_locale][CHANNR] + RADIO_AFC_SCALE / 2) >>
+              RADIO_AFC_SHIFT;
+    }
+
+    // Add it to FSCTRL0 without wrapping around
+    fsctrl0 = (int8_t) radio_afc_base + afc;
+
+    if (fsctrl0 > 127) {
+        fsctrl0 = 127;
+    }
+
+    if (fsctrl0 < -128) {
+        fsctrl0 = -128;
+    }
+
+    // Apply it
+    radio_afc = fsctrl0 - (int8_t) radio_afc_base;
+    FSCTRL0 = fsctrl0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_AFC_UPDATE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Move frequency offset correction of current channel towards given offset
+    radio estimated for a packet with right CRC (what is left of it once
+    FSCTRL0 is applied). A fraction of it only is taken, so that a single
+    noisy estimate can't throw channel off.
+*/
+void radio_afc_update(int8_t freqest) {
+
+    // Initialize correction
+    int16_t afc;
+
+    // If channel not tracked
+    if (!(radio_options & RADIO_OPTION_AFC) || CHANNR >= RADIO_CAL_CHANNELS ||
+        radio_locale == RADIO_LOCALE_NONE) {
+
+        // Nothing to do
+        return;
+    }
+
+    // Filter estimate into correction
+    afc = radio_afcs[radio_locale][CHANNR] +
+          freqest * (RADIO_AFC_SCALE / RADIO_AFC_GAIN);
+
+    // Keep it within FSCTRL0 range
+    if (afc > RADIO_AFC_MAX) {
+        afc = RADIO_AFC_MAX;
+    }
+
+    if (afc < -RADIO_AFC_MAX) {
+        afc = -RADIO_AFC_MAX;
+    }
+
+    // Store it
+    radio_afcs[radio_locale][CHANNR] = afc;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_CALIBRATE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Calibrate all channels of current locale which can be cached again (e.g.
+    after temperature or voltage changed), and return their number (none if
+    band set by hand).
+*/
+uint8_t radio_calibrate(void) {
+
+    // Remember current channel
+    uint8_t channel = CHANNR;
+
+    // Initialize channel to calibrate
+    uint8_t n = 0;
+
+    // If no locale
+    if (radio_locale == RADIO_LOCALE_NONE) {
+
+        // Nothing to calibrate
+        return 0;
+    }
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Forget calibrations
+    radio_cals_valid[radio_locale] = 0;
+
+    // Calibrate channels
+    while (n < RADIO_CAL_CHANNELS) {
+        radio_cal_channel(n++);
+    }
+
+    // Go back to current channel
+    CHANNR = channel;
+
+    // If it has a calibration
+    if (channel < RADIO_CAL_CHANNELS) {
+
+        // Restore it
+        FSCAL3 = radio_cals[radio_locale][channel].fscal3;
+        FSCAL2 = radio_cals[radio_locale][channel].fscal2;
+        FSCAL1 = radio_cals[radio_locale][channel].fscal1;
+    }
+
+    // Return number of channels calibrated
+    return n;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_LOCALE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Switch band (frequency and PA power) and return locale applied (unknown
+    ones are ignored). Each locale keeps its own channel calibrations, so that
+    switching back and forth costs no calibration.
+*/
+uint8_t radio_set_locale(uint8_t locale) {
+
+    // Get locale settings
+    __code struct radio_locale *settings;
+
+    // If locale unknown
+    if (locale >= RADIO_LOCALES) {
+
+        // Keep current one
+        return radio_locale;
+    }
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Apply settings
+    settings = &radio_locales[locale];
+    FREQ2 = settings->freq2;
+    FREQ1 = settings->freq1;
+    FREQ0 = settings->freq0;
+    PA_TABLE1 = settings->pa_table1;
+
+    // Store locale
+    radio_locale = locale;
+
+    // Return it
+    return radio_locale;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GET_LOCALE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+uint8_t radio_get_locale(void) {
+
+    // Return current locale
+    return radio_locale;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_DETECT_LOCALE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet given by master in each locale (current one first) and listen
+    for an answer (timeout in ms, default one if 0, since waiting forever would
+    never leave first locale): first locale answered on is kept, and answer is
+    sent to master. Otherwise, current locale (first one if band was set by
+    hand) is restored and error returned.
+*/
+uint8_t radio_detect_locale(uint8_t tx_channel, uint8_t rx_channel,
+                            uint32_t timeout) {
+
+    // Remember current locale (first one if none)
+    uint8_t locale = radio_locale != RADIO_LOCALE_NONE ? radio_locale : 0;
+
+    // Initialize number of locales tried, and error
+    uint8_t n = 0;
+    uint8_t error = 0;
+
+    // Wait for a bounded time in each locale
+    if (timeout == 0) {
+        timeout = RADIO_LOCALE_TIMEOUT;
+    }
+
+    // If band was set by hand, switch to first locale before sending
+    if (radio_locale == RADIO_LOCALE_NONE) {
+        radio_set_locale(locale);
+    }
+
+    // Get packet from master and send it in current locale
+    radio_send(tx_channel, 0, 0);
+
+    // Go through locales
+    while (1) {
+
+        // Listen for answer
+        error = radio_receive(rx_channel, timeout);
+
+        // If answer (or interruption)
+        if (error != RADIO_ERROR_TIMEOUT) {
+
+            // Exit
+            break;
+        }
+
+        // If all locales tried
+        if (++n == RADIO_LOCALES) {
+
+            // Exit
+            break;
+        }
+
+        // Switch to next locale
+        radio_set_locale((locale + n) % RADIO_LOCALES);
+
+        // Resend packet in it
+        radio_set_channel(tx_channel);
+        radio_resend();
+    }
+
+    // If no answer
+    if (error != 0) {
+
+        // Restore locale
+        radio_set_locale(locale);
+    }
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_CLEAR
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Fill given RX ring slot with a byte which cannot appear in 4b6b encoded
+    data, so that the number of bytes DMA wrote so far can be read from it.
+*/
+void radio_rx_clear(uint8_t slot) {
+
+    // Get slot
+    __xdata uint8_t *buffer = radio_rx_ring[slot];
+
+    // Initialize byte index
+    uint8_t n = radio_rx_header;
+
+    // Fill slot
+    while (n < RADIO_MAX_PACKET_SIZE) {
+        buffer[n++] = RADIO_RX_FILL;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_ARM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Let DMA move received bytes into head slot of RX ring (already cleared),
+    right after the header. Without packet engine, zero byte ending packet on
+    air is looked for in bytes written (or DMA ends packet at end of slot).
+    With packet engine, radio ends packets, and DMA only moves bytes.
+*/
+void radio_rx_arm(void) {
+
+    // Initialize transfer length and DMA interrupt
+    uint8_t len = RADIO_MAX_PACKET_SIZE - radio_rx_header;
+    uint8_t irq = DMA_CFG1_IRQMASK;
+
+    // Use head slot as RX buffer
+    radio_rx_buffer = radio_rx_ring[radio_rx_head];
+
+    // Reset buffer size, scan index and filter result
+    radio_rx_buffer_size = 0;
+    radio_rx_scan = radio_rx_header;
+    radio_rx_matched = 0;
+
+    // If radio ends packets itself, DMA just follows
+    if (radio_packet != RADIO_PACKET_SOFTWARE) {
+        irq = 0;
+    }
+
+    // Reset DMA interrupt flag
+    DMAIRQ &= ~DMA_MASK_RADIO;
+
+    // Move bytes from radio to buffer, one per radio trigger
+    dma_configure(DMA_CHANNEL_RADIO,
+                  (uint16_t) &RFDXADDR,
+                  (uint16_t) &radio_rx_buffer[radio_rx_header],
+                  len,
+                  DMA_CFG0_WORDSIZE_8 | DMA_CFG0_TMODE_SINGLE |
+                  DMA_CFG0_TRIGGER_RADIO,
+                  DMA_CFG1_SRCINC_0 | DMA_CFG1_DESTINC_1 | irq |
+                  DMA_CFG1_PRIORITY_HIGH);
+
+    // Arm DMA
+    dma_arm(DMA_CHANNEL_RADIO);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_RESET
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Empty RX ring, for packets to come on given channel. Ring must be closed.
+*/
+void radio_rx_reset(uint8_t channel) {
+
+    // Initialize slot
+    uint8_t slot = 0;
+
+    // Store channel
+    radio_rx_channel = channel;
+
+    // Reset slots
+    radio_rx_head = 0;
+    radio_rx_tail = 0;
+    radio_rx_count = 0;
+    radio_rx_sent = 0;
+
+    // Clear them
+    while (slot < RADIO_RX_SLOTS) {
+        radio_rx_clear(slot++);
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_START
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Empty RX ring and start listening on given channel. Radio then keeps
+    receiving in the background until stopped or ring is full.
+*/
+void radio_rx_start(uint8_t channel) {
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Empty ring
+    radio_rx_reset(channel);
+
+    // Prepare head slot
+    radio_rx_arm();
+
+    // Open ring
+    radio_rx_open = 1;
+
+    // Put radio in receive state
+    radio_state_receive();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_STOP
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void radio_rx_stop(void) {
+
+    // Close ring, so that ISRs leave radio alone
+    radio_rx_open = 0;
+
+    // Put radio in idle state
+    radio_state_idle();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_DATA
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Index of first packet byte in RX ring slots, after header, and after length
+    byte packets start with on air with variable packet length.
+*/
+uint8_t radio_rx_data(void) {
+
+    // If packets start with their length
+    if (radio_packet == RADIO_PACKET_VARIABLE) {
+
+        // Skip it
+        return radio_rx_header + 1;
+    }
+
+    // Otherwise, bytes start right after header
+    return radio_rx_header;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_MATCH
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Tell whether packet in head slot, of which given number of bytes (header
+    included) were received, passes address filter: its first bytes must
+    match filter ones wherever mask bits are set. Every packet passes with no
+    filter.
+*/
+uint8_t radio_rx_match(uint8_t size) {
+
+    // Get first packet byte
+    uint8_t start = radio_rx_data();
+
+    // Initialize byte index
+    uint8_t n = 0;
+
+    // If no filtering
+    if (radio_filter.size == 0) {
+
+        // Packet passes
+        return 1;
+    }
+
+    // If packet too short
+    if (size < start + radio_filter.size) {
+
+        // Packet filtered out
+        return 0;
+    }
+
+    // Compare bytes
+    while (n < radio_filter.size) {
+
+        // If they differ
+        if ((radio_rx_buffer[start + n] ^ radio_filter.bytes[n]) &
+            radio_filter.mask[n]) {
+
+            // Packet filtered out
+            return 0;
+        }
+
+        n++;
+    }
+
+    // Packet passes
+    return 1;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_DROP
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Drop packet filtered out in head slot (ended or not), and go on listening
+    with next one, without ending receive window. Packet ends without size, so
+    that its slot is cleared outside ISRs, once radio_rx_ready() frees it.
+    Called with interrupts disabled, or from ISRs.
+*/
+void radio_rx_drop(void) {
+
+    // Update statistics
+    radio_stats.rx_filtered++;
+
+    // End packet as dropped
+    radio_rx_end(0);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_END
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    End packet of given size (header included, 0 if dropped) in head slot and
+    go on listening with next one, unless ring is full. Called with interrupts
+    disabled, or from ISRs.
+*/
+void radio_rx_end(uint8_t size) {
+
+    // End packet
+    radio_state_idle();
+
+    // Apply correction to next packets
+    radio_afc_apply();
+
+    // Store its size
+    radio_rx_sizes[radio_rx_head] = size;
+
+    // One more complete slot
+    radio_rx_count++;
+
+    // If ring full
+    if (radio_rx_count == RADIO_RX_SLOTS) {
+
+        // Stay idle until a slot is read
+        return;
+    }
+
+    // Move to next slot
+    radio_rx_head = (radio_rx_head + 1) & (RADIO_RX_SLOTS - 1);
+
+    // Prepare it
+    radio_rx_arm();
+
+    // Go back to receive state
+    RFST = RFST_SRX;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_NEXT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    End packet of given size (header included) in head slot and go on
+    listening with next one, unless ring is full. Packets filtered out (if
+    not matched while bytes came) are dropped instead. Called with interrupts
+    disabled, or from ISRs.
+*/
+void radio_rx_next(uint8_t size) {
+
+    // If packet not addressed to us
+    if (!radio_rx_matched && !radio_rx_match(size)) {
+
+        // Drop it
+        radio_rx_drop();
+
+        // Exit
+        return;
+    }
+
+    // Fill metadata while radio still holds it: link quality (CRC status in
+    // MSB), frequency offset estimate and number of bytes received
+    if (radio_options & RADIO_OPTION_METADATA) {
+        radio_rx_buffer[radio_rx_meta] = RF_LQI;
+        radio_rx_buffer[radio_rx_meta + 1] = RF_FREQEST;
+        radio_rx_buffer[radio_rx_meta + 2] = size - radio_rx_header;
+    }
+
+    // Remember frequency offset estimate, until CRC is checked
+    radio_rx_freqests[radio_rx_head] = RF_FREQEST;
+
+    // If radio checked CRC and found it right, track frequency offset now
+    if ((PKTCTRL0 & RF_PKTCTRL0_CRC_EN) && (RF_LQI & RF_LQI_CRC_OK)) {
+        radio_afc_update(RF_FREQEST);
+    }
+
+    // End it
+    radio_rx_end(size);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_POLL
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Go through bytes DMA wrote in head slot since last call (at most given
+    number, so that interrupts are not held off long), end packet on zero
+    byte, and return whether it did. Called every millisecond by timer ISR,
+    so that packets end right after their zero byte even when nothing else
+    polls (e.g. while streaming to master), and by DMA ISR (going through
+    whole slot) before ending a full one. Cut-through also forwards bytes
+    gone through (scan stops at first byte looking unwritten). Address filter
+    runs as soon as the bytes it covers came, so that packets filtered out
+    are dropped (and radio listens with next slot) before they end. With
+    packet engine, radio ISR ends every packet, and only filter is run.
+*/
+uint8_t radio_rx_poll(uint8_t max) {
+
+    // Initialize byte count, byte, whether packet ends on zero byte, and
+    // whether it ended (or was dropped)
+    uint8_t n = 0;
+    uint8_t byte = RADIO_RX_FILL;
+    uint8_t zero = radio_packet == RADIO_PACKET_SOFTWARE;
+    uint8_t end = 0;
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // If packet end known to radio ISR, and no filter left to run
+    if (!zero && (radio_filter.size == 0 || radio_rx_matched)) {
+
+        // Nothing to do
+        return 0;
+    }
+
+    // Keep ISRs from moving to next slot meanwhile
+    EA = 0;
+
+    // If listening and packet started in head slot
+    if (radio_rx_open && radio_rx_count < RADIO_RX_SLOTS &&
+        radio_rx_buffer_size > 0) {
+
+        // Go through bytes written by DMA so far
+        while (n < max && radio_rx_scan < RADIO_MAX_PACKET_SIZE &&
+               (byte = radio_rx_buffer[radio_rx_scan]) != RADIO_RX_FILL) {
+
+            // Update byte counts
+            radio_rx_scan++;
+            n++;
+
+            // If end of packet
+            if (byte == 0 && zero) {
+
+                // Next slot
+                radio_rx_next(radio_rx_scan);
+                end = 1;
+
+                // Exit
+                break;
+            }
+
+            // If bytes covered by filter came
+            if (!radio_rx_matched && radio_filter.size > 0 &&
+                radio_rx_scan == radio_rx_data() + radio_filter.size) {
+
+                // If packet not addressed to us
+                if (!radio_rx_match(radio_rx_scan)) {
+
+                    // Drop it right away
+                    radio_rx_drop();
+                    end = 1;
+
+                    // Exit
+                    break;
+                }
+
+                // Otherwise, keep it
+                radio_rx_matched = 1;
+            }
+        }
+    }
+
+    // Restore interrupt state
+    EA = ea;
+
+    // Return whether packet ended
+    return end;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_LENGTH
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Number of bytes in given RX ring slot, header included, when packets have
+    a fixed length, or start with their length.
+*/
+uint8_t radio_rx_length(__xdata uint8_t *packet) {
+
+    // If packets have a fixed length
+    if (radio_packet == RADIO_PACKET_FIXED) {
+
+        // Header and packet length (as far as slot goes)
+        return radio_rx_header + min(PKTLEN,
+                                     RADIO_MAX_PACKET_SIZE - radio_rx_header);
+    }
+
+    // Header, length byte and as many bytes as it says (as far as slot goes)
+    return radio_rx_header + 1 +
+           min(packet[radio_rx_header],
+               RADIO_MAX_PACKET_SIZE - radio_rx_header - 1);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_DECODE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Decode 4b6b bytes of packet in given RX ring slot of given size (header
+    included) in place, and return its new size. Symbol error count goes in
+    last header byte. Length byte packets start with is kept, and updated.
+    Zero byte ending packet without packet engine is dropped.
+*/
+uint8_t radio_rx_decode(__xdata uint8_t *packet, uint8_t size) {
+
+    // Get first encoded byte
+    uint8_t start = radio_rx_data();
+
+    // Initialize symbol error count
+    uint8_t errors = 0;
+
+    // If no encoded byte
+    if (size <= start) {
+
+        // Keep packet as is
+        return size;
+    }
+
+    // Leave out end byte, which is no data
+    if (radio_packet == RADIO_PACKET_SOFTWARE && packet[size - 1] == 0) {
+        size--;
+    }
+
+    // Decode bytes
+    size = start + medtronic_decode(&packet[start], size - start, &errors);
+
+    // Store error count
+    packet[radio_rx_header - 1] = errors;
+
+    // Update length byte
+    if (start > radio_rx_header) {
+        packet[radio_rx_header] = size - start;
+    }
+
+    // Return new size
+    return size;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_CHECK
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Check CRC8 ending decoded bytes of packet in given RX ring slot of given
+    size (header included, and length byte packets start with excluded), and
+    return error if it is wrong (or missing).
+*/
+uint8_t radio_rx_check(__xdata uint8_t *packet, uint8_t size) {
+
+    // Get first byte and number of bytes (CRC included)
+    uint8_t start = radio_rx_data();
+    uint8_t n = size > start ? size - start : 0;
+
+    // Get CRC check
+    uint8_t check = radio_crc & RADIO_CRC_CHECK_MASK;
+
+    // If message CRC
+    if (check == RADIO_CRC_CHECK_8) {
+
+        // If right
+        if (n >= 1 &&
+            medtronic_crc8(&packet[start], n - 1) == packet[start + n - 1]) {
+
+            // Packet good
+            return 0;
+        }
+
+        // Packet bad
+        return RADIO_ERROR_CRC;
+    }
+
+    // Nothing to check
+    return 0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_PASSED
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Tell that oldest complete packet of RX ring has a right CRC, checked by
+    firmware, so that its frequency offset estimate can be tracked. Packets
+    checked by radio were already tracked when they ended. Correction is
+    applied when next packet ends.
+*/
+void radio_rx_passed(void) {
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // If radio did not check CRC
+    if (!(PKTCTRL0 & RF_PKTCTRL0_CRC_EN)) {
+
+        // Track frequency offset, keeping ISRs from applying correction
+        // meanwhile
+        EA = 0;
+        radio_afc_update(radio_rx_freqests[radio_rx_tail]);
+        EA = ea;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_TAKE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Get bytes of oldest complete packet of RX ring for firmware itself (header
+    and length byte excluded, decoded when decoding) and their number. Slot
+    must be freed once done with them.
+*/
+__xdata uint8_t * radio_rx_take(uint8_t *size) {
+
+    // Get oldest slot, its size and first packet byte
+    __xdata uint8_t *packet = radio_rx_ring[radio_rx_tail];
+    uint8_t n = radio_rx_sizes[radio_rx_tail];
+    uint8_t start = radio_rx_data();
+
+    // Decode 4b6b bytes if asked
+    if (radio_options & RADIO_OPTION_DECODE) {
+        n = radio_rx_decode(packet, n);
+    }
+
+    // Store number of bytes
+    *size = n > start ? n - start : 0;
+
+    // Return them
+    return &packet[start];
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_DRAIN
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send oldest complete packet of RX ring to master and free its slot. Its
+    size was stored when it ended. Packets without data, or with wrong CRC,
+    are dropped and error returned instead.
+*/
+uint8_t radio_rx_drain(void) {
+
+    // Get oldest slot and its size
+    __xdata uint8_t *packet = radio_rx_ring[radio_rx_tail];
+    uint8_t n = radio_rx_sizes[radio_rx_tail];
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // Check for absence of data (zero end byte or length only)
+    if (n == radio_rx_header + 1 && packet[radio_rx_header] == 0 &&
+        radio_packet != RADIO_PACKET_FIXED) {
+
+        // Assign no data error (nothing forwarded to master)
+        error = RADIO_ERROR_NO_DATA;
+    }
+
+    // Otherwise
+    else {
+
+        // Decode 4b6b bytes if asked (nothing forwarded yet then)
+        if (radio_options & RADIO_OPTION_DECODE) {
+            n = radio_rx_decode(packet, n);
+        }
+
+        // Check CRC if asked and still possible to drop packet
+        if (radio_rx_sent == 0) {
+            error = radio_rx_check(packet, n);
+
+            // If checked and right, track frequency offset
+            if (error == 0 &&
+                (radio_crc & RADIO_CRC_CHECK_MASK) != RADIO_CRC_CHECK_NONE) {
+                radio_rx_passed();
+            }
+        }
+    }
+
+    // If packet good
+    if (error == 0) {
+
+        // If nothing forwarded yet
+        if (radio_rx_sent == 0) {
+
+            // Announce packet length
+            usb_put_length(n);
+        }
+
+        // Send bytes not already forwarded to master
+        while (radio_rx_sent < n) {
+            usb_put_byte(packet[radio_rx_sent++]);
+        }
+
+        // End packet
+        usb_flush_bytes();
+    }
+
+    // Free slot
+    radio_rx_free();
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_FREE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Free oldest slot of RX ring, and go back to listening if ring was full.
+*/
+void radio_rx_free(void) {
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // Clear slot
+    radio_rx_clear(radio_rx_tail);
+    radio_rx_sent = 0;
+
+    // Keep ISRs away from ring meanwhile
+    EA = 0;
+
+    // Move to next slot
+    radio_rx_tail = (radio_rx_tail + 1) & (RADIO_RX_SLOTS - 1);
+
+    // If ring was full and radio should still listen
+    if (radio_rx_count-- == RADIO_RX_SLOTS && radio_rx_open) {
+
+        // Move to freed slot
+        radio_rx_head = (radio_rx_head + 1) & (RADIO_RX_SLOTS - 1);
+
+        // Prepare it
+        radio_rx_arm();
+
+        // Go back to receive state
+        RFST = RFST_SRX;
+    }
+
+    // Restore interrupt state
+    EA = ea;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_READY
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Free (and clear) oldest slots of RX ring holding dropped packets, and tell
+    whether a packet is left in ring. Not called from ISRs.
+*/
+uint8_t radio_rx_ready(void) {
+
+    // While oldest slot holds a dropped packet
+    while (radio_rx_count > 0 && radio_rx_sizes[radio_rx_tail] == 0) {
+
+        // Free it
+        radio_rx_free();
+    }
+
+    // Return whether a packet is in ring
+    return radio_rx_count > 0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_FORWARD
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Cut-through: put bytes of packet being received in USB FIFO as soon as DMA
+    wrote them, so that master gets them every time FIFO is full. Only done
+    when ring is otherwise empty, so that packet is in oldest slot, and none of
+    these bytes is the zero end byte. Nothing is forwarded before first byte
+    after header is known to be non-zero: header of a packet without data
+    would otherwise reach master, nor before packet passed address filter.
+    Needs zero framing, since packet length is only known once packet ends.
+    Bytes looking unwritten (RX buffer filler) hold forwarding back until
+    packet is complete. Not done with packet engine, which may drop a packet
+    after its first bytes.
+*/
+void radio_rx_forward(void) {
+
+    // Get oldest slot
+    __xdata uint8_t *packet = radio_rx_ring[radio_rx_tail];
+
+    // Initialize number of bytes known to be written
+    uint8_t n = 0;
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // If packet engine used
+    if (radio_packet != RADIO_PACKET_SOFTWARE) {
+
+        // Nothing to do
+        return;
+    }
+
+    // Read it while ISRs cannot move to next slot
+    EA = 0;
+
+    // If packet started, passed filter, and nothing older in ring
+    if (radio_rx_count == 0 && radio_rx_buffer_size > 0 &&
+        (radio_filter.size == 0 || radio_rx_matched)) {
+        n = radio_rx_scan;
+    }
+
+    // Restore interrupt state
+    EA = ea;
+
+    // If nothing forwarded yet
+    if (radio_rx_sent == 0) {
+
+        // If first byte after header not received yet, or zero (packet
+        // without data, which never reaches master)
+        if (n <= radio_rx_header || packet[radio_rx_header] == 0) {
+
+            // Wait for it
+            return;
+        }
+    }
+
+    // Put new bytes in USB FIFO
+    while (radio_rx_sent < n) {
+        usb_put_byte(packet[radio_rx_sent++]);
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_CUT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    End packet partly forwarded to master, so that what follows is not taken
+    as part of it.
+*/
+void radio_rx_cut(void) {
+
+    // If bytes already forwarded
+    if (radio_rx_sent > 0) {
+
+        // End packet
+        usb_flush_bytes();
+
+        // Reset count
+        radio_rx_sent = 0;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_OPTIONS
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Set RX/TX options and return the ones applied. Some need length framing.
+*/
+uint8_t radio_set_options(uint8_t options) {
+
+    // Initialize RX header size, and remember AFC state
+    uint8_t header = RADIO_HEADER_SIZE;
+    uint8_t afc = radio_options;
+
+    // Store known options
+    radio_options = options & RADIO_OPTIONS;
+
+    // Options passing bytes of any value (e.g. zeros) need length framing
+    if (radio_framing == USB_FRAMING_ZERO) {
+        radio_options &= ~RADIO_OPTIONS_FRAMED;
+    }
+
+    // Otherwise
+    else {
+
+        // Packet length is only known once packet ended, too late to give it
+        // to master before bytes when cutting through
+        radio_options &= ~RADIO_OPTION_RX_CUT_THROUGH;
+    }
+
+    // Make room for timestamp in RX header
+    if (radio_options & RADIO_OPTION_TIMESTAMP) {
+        header += RADIO_TIMESTAMP_SIZE;
+    }
+
+    // Metadata goes after it
+    radio_rx_meta = header;
+
+    // Make room for metadata in RX header, which is only known once packet
+    // ends, so that header can't be forwarded before
+    if (radio_options & RADIO_OPTION_METADATA) {
+        header += RADIO_METADATA_SIZE;
+        radio_options &= ~RADIO_OPTION_RX_CUT_THROUGH;
+    }
+
+    // Same for symbol error count of decoded packets (last header byte)
+    if (radio_options & RADIO_OPTION_DECODE) {
+        header += RADIO_DECODE_SIZE;
+        radio_options &= ~RADIO_OPTION_RX_CUT_THROUGH;
+    }
+
+    // Otherwise, no CRC to check
+    else {
+        radio_crc &= ~RADIO_CRC_CHECK_MASK;
+    }
+
+    // Packets to encode must be complete before being sent
+    if (radio_options & RADIO_OPTION_ENCODE) {
+        radio_options &= ~RADIO_OPTION_TX_CUT_THROUGH;
+    }
+
+    // If RX header size changes
+    if (header != radio_rx_header) {
+
+        // Stop using RX ring, which will be laid out again on next start
+        radio_rx_stop();
+
+        // Store it
+        radio_rx_header = header;
+
+        // Fit packet length to room it leaves in RX ring slots
+        radio_set_packet(radio_packet, radio_packet_length);
+    }
+
+    // If AFC switched, add or remove corrections with radio idle
+    if ((radio_options ^ afc) & RADIO_OPTION_AFC) {
+        radio_rx_stop();
+        radio_afc_apply();
+    }
+
+    // Calibrate on every start of RX/TX, unless calibrations are cached
+    MCSM0 = (MCSM0 & ~RF_MCSM0_FS_AUTOCAL_MASK) |
+            (radio_options & RADIO_OPTION_CAL_CACHE ?
+             RF_MCSM0_FS_AUTOCAL_NEVER : RF_MCSM0_FS_AUTOCAL_FROM_IDLE);
+
+    // Return them
+    return radio_options;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GET_OPTIONS
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+uint8_t radio_get_options(void) {
+
+    // Return current options
+    return radio_options;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_FRAMING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Choose how packets end with master, and return framing applied. With
+    length framing, master gets and gives a 2-byte length (MSB first) before
+    bytes instead of a zero after them, so that any byte value can be passed.
+    Packets on air are left as they are (packet mode alone decides whether
+    they start with a length byte): without packet engine, master gives zero
+    ending packet among bytes unless encoding. Radio must stop listening,
+    since RX ring depends on it.
+*/
+uint8_t radio_set_framing(uint8_t framing) {
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Apply framing to USB and store it
+    radio_framing = usb_set_framing(framing);
+
+    // Keep options it allows
+    radio_set_options(radio_options);
+
+    // Return it
+    return radio_framing;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GET_FRAMING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+uint8_t radio_get_framing(void) {
+
+    // Return current framing
+    return radio_framing;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_PACKET
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Choose how radio knows where packets end, and return mode applied (unknown
+    ones are ignored). Length is the packet length in fixed mode, and the max
+    one in variable mode (first byte excluded); radio drops longer packets.
+    It is cut down to what RX ring slots hold after the RX header (and again
+    whenever header size changes). With packet engine, radio goes idle by
+    itself after last byte and says so with its DONE interrupt, which ends
+    packet in RX ring. Radio must stop listening, since RX ring depends on it.
+*/
+uint8_t radio_set_packet(uint8_t packet, uint8_t length) {
+
+    // Initialize max length (what DMA moves into RX ring slots)
+    uint8_t max = RADIO_MAX_PACKET_SIZE - radio_rx_header;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Identify mode
+    switch (packet) {
+
+        // Radio ignores length
+        case RADIO_PACKET_SOFTWARE:
+            PKTCTRL0 &= ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+            PKTLEN = 0xFF;
+            break;
+
+        // Fixed length
+        case RADIO_PACKET_FIXED:
+            PKTCTRL0 &= ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+            PKTLEN = length ? min(length, max) : max;
+            break;
+
+        // Length in first byte
+        case RADIO_PACKET_VARIABLE:
+            PKTCTRL0 = (PKTCTRL0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK) |
+                       RF_PKTCTRL0_LENGTH_CONFIG_VARIABLE;
+            PKTLEN = length ? min(length, max - 1) : max - 1;
+            break;
+
+        // Unknown mode
+        default:
+            return radio_packet;
+    }
+
+    // Store mode and length
+    radio_packet = packet;
+    radio_packet_length = length;
+
+    // Return it
+    return radio_packet;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_CRC
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Choose CRC packets received must end with (none or message CRC8), and
+    whether send/receive retries at once when it is wrong, and return policy
+    applied (unknown checks are ignored). CRC is computed on decoded bytes, so
+    a check needs decoding on. Packets with wrong CRC never reach master.
+*/
+uint8_t radio_set_crc(uint8_t crc) {
+
+    // Get check
+    uint8_t check = crc & RADIO_CRC_CHECK_MASK;
+
+    // If check known, and bytes decoded if needed
+    if (check < RADIO_CRC_CHECKS &&
+        (check == RADIO_CRC_CHECK_NONE ||
+         (radio_options & RADIO_OPTION_DECODE))) {
+
+        // Store policy
+        radio_crc = crc & (RADIO_CRC_CHECK_MASK | RADIO_CRC_RETRY);
+    }
+
+    // Return it
+    return radio_crc;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GET_CRC
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+uint8_t radio_get_crc(void) {
+
+    // Return CRC policy
+    return radio_crc;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_FILTER
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Set address filter first bytes of received packets (e.g. packet type and
+    pump serial) must match wherever mask bits are set, and return number of
+    bytes compared on air (none turns filter off, as do too many bytes). With
+    4b6b flag, bytes and mask are given decoded, and encoded here. Radio must
+    stop listening, since ISRs use filter.
+*/
+uint8_t radio_set_filter(uint8_t flags, uint8_t size, uint8_t *bytes,
+                         uint8_t *mask) {
+
+    // Initialize byte index
+    uint8_t n = 0;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // If too many bytes
+    if (size > (flags & RADIO_FILTER_4B6B ? RADIO_FILTER_SIZE * 2 / 3 :
+                                            RADIO_FILTER_SIZE)) {
+
+        // Turn filter off
+        size = 0;
+    }
+
+    // Store bytes and mask
+    while (n < size) {
+        radio_filter.bytes[n] = bytes[n];
+        radio_filter.mask[n] = mask[n];
+        n++;
+    }
+
+    // Encode them if asked
+    if (flags & RADIO_FILTER_4B6B) {
+        medtronic_encode(radio_filter.bytes, size, 0);
+        size = medtronic_encode(radio_filter.mask, size, 1);
+    }
+
+    // Store size
+    radio_filter.size = size;
+
+    // Return it
+    return radio_filter.size;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_WAIT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Listen on given channel until a packet is complete in RX ring, or timeout
+    (ms) expires, or master interrupts, and return error if it is not there.
+    Cut-through gives master bytes meanwhile. When staging is allowed, first
+    bytes from master are taken as next packet to send instead of as an
+    interruption.
+*/
+uint8_t radio_rx_wait(uint8_t channel, uint32_t timeout) {
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // If not already listening on channel
+    if (!radio_rx_open || radio_rx_channel != channel) {
+
+        // Start listening
+        radio_rx_start(channel);
+    }
+
+    // Reset timer counter
+    timer_counter_reset();
+
+    // Loop parallel to DMA and react when a packet is complete
+    while (1) {
+
+        // Look for end of packet
+        radio_rx_poll(RADIO_RX_POLL_BYTES);
+
+        // If packet in ring
+        if (radio_rx_ready()) {
+
+            // Exit
+            break;
+        }
+
+        // If cut-through wanted
+        if (radio_options & RADIO_OPTION_RX_CUT_THROUGH) {
+
+            // Give master bytes received so far
+            radio_rx_forward();
+        }
+
+        // If no bytes received
+        if (radio_rx_buffer_size == 0) {
+
+            // If timeout given and expired
+            if (timeout > 0 && timer_counter > timeout) {
+
+                // Assign timeout error
+                error = RADIO_ERROR_TIMEOUT;
+
+                // Exit
+                break;
+            }
+        }
+
+        // If master sends next packet
+        if (radio_tx_staging && usb_rx_ready()) {
+
+            // Stage it (only once)
+            radio_tx_stage();
+            radio_tx_staging = 0;
+        }
+
+        // If interruption requested
+        if (usb_poll_byte() != -1) {
+
+            // Assign error
+            error = RADIO_ERROR_INTERRUPTED;
+
+            // Exit
+            break;
+        }
+    }
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RX_WINDOW
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Wait until a packet is in RX ring (already open), as radio_rx_wait() would,
+    but within a window timed by timer alarm: sync word must come before first
+    deadline, and packet must end before second one (us, from given start).
+*/
+uint8_t radio_rx_window(uint32_t start, uint32_t sync, uint32_t end) {
+
+    // Initialize error and whether sync word came in time
+    uint8_t error = 0;
+    uint8_t synced = 0;
+
+    // Arm sync deadline
+    timer_alarm_set(start + sync, TIMER_STROBE_NONE);
+
+    // Loop parallel to DMA and react when a packet is complete
+    while (1) {
+
+        // Look for end of packet
+        radio_rx_poll(RADIO_RX_POLL_BYTES);
+
+        // If packet in ring
+        if (radio_rx_ready()) {
+
+            // Exit
+            break;
+        }
+
+        // If cut-through wanted
+        if (radio_options & RADIO_OPTION_RX_CUT_THROUGH) {
+
+            // Give master bytes received so far
+            radio_rx_forward();
+        }
+
+        // If deadline reached
+        if (timer_alarm == TIMER_ALARM_RANG) {
+
+            // If sync word came in time
+            if (!synced && radio_rx_buffer_size > 0) {
+
+                // Arm packet end deadline
+                timer_alarm_set(start + end, TIMER_STROBE_NONE);
+                synced = 1;
+            }
+
+            // Otherwise
+            else {
+
+                // Assign timeout error
+                error = RADIO_ERROR_TIMEOUT;
+
+                // Exit
+                break;
+            }
+        }
+
+        // If interruption requested
+        if (usb_poll_byte() != -1) {
+
+            // Assign error
+            error = RADIO_ERROR_INTERRUPTED;
+
+            // Exit
+            break;
+        }
+    }
+
+    // Disarm deadline
+    timer_alarm_clear();
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RECEIVE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Timeout input given in ms. Packets are moved by DMA into RX ring. Ring is
+    closed once a packet was returned, so that radio does not stay in RX
+    between commands, and next receive only gets packets coming after it
+    started (radio_stream() and history download keep ring open instead).
+*/
+uint8_t radio_receive(uint8_t channel, uint32_t timeout) {
+
+    // Wait for packet, and get error if there is one
+    uint8_t error = radio_rx_wait(channel, timeout);
+
+    // If no error
+    if (error == 0) {
+
+        // Send oldest packet to master
+        error = radio_rx_drain();
+    }
+
+    // Put radio back in idle state
+    radio_rx_stop();
+
+    // If error
+    if (error != 0) {
+
+        // End packet master may have started to get
+        radio_rx_cut();
+    }
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_STREAM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Keep listening on given channel and send every packet to master as soon as
+    it is complete, until master interrupts or total timeout (ms) expires. No
+    timeout given means listening until interrupted. Packets without data, or
+    with wrong CRC, are dropped.
+*/
+uint8_t radio_stream(uint8_t channel, uint32_t timeout) {
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // If not already listening on channel
+    if (!radio_rx_open || radio_rx_channel != channel) {
+
+        // Start listening
+        radio_rx_start(channel);
+    }
+
+    // Reset timer counter
+    timer_counter_reset();
+
+    // Loop parallel to DMA and send packets as they come
+    while (1) {
+
+        // Look for end of packet
+        radio_rx_poll(RADIO_RX_POLL_BYTES);
+
+        // If packet in ring
+        if (radio_rx_ready()) {
+
+            // Send oldest packet to master
+            radio_rx_drain();
+        }
+
+        // If cut-through wanted
+        else if (radio_options & RADIO_OPTION_RX_CUT_THROUGH) {
+
+            // Give master bytes received so far
+            radio_rx_forward();
+        }
+
+        // If timeout given and expired
+        if (timeout > 0 && timer_counter > timeout) {
+
+            // Assign timeout error
+            error = RADIO_ERROR_TIMEOUT;
+
+            // Exit
+            break;
+        }
+
+        // If interruption requested
+        if (usb_poll_byte() != -1) {
+
+            // Assign error
+            error = RADIO_ERROR_INTERRUPTED;
+
+            // Exit
+            break;
+        }
+    }
+
+    // Put radio back in idle state
+    radio_rx_stop();
+
+    // End packet master may have started to get
+    radio_rx_cut();
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SEND
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet from master, and return error if first transmission of it was
+    lost (cut-through underflow). Repeats are sent from whole buffer anyway.
+*/
+uint8_t radio_send(uint8_t channel, uint8_t repeat, uint32_t delay) {
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Get ready for new packet
+    radio_tx_begin();
+
+    // If cut-through wanted (and length byte needn't wait for last byte)
+    if ((radio_options & RADIO_OPTION_TX_CUT_THROUGH) &&
+        (radio_packet != RADIO_PACKET_VARIABLE ||
+         radio_framing == USB_FRAMING_LENGTH)) {
+
+        // Send bytes while they come
+        error = radio_transmit_cut_through();
+    }
+
+    // Otherwise
+    else {
+
+        // Fill buffer
+        while (!radio_tx_fill(1)) {
+            NOP();
+        }
+
+        // Finish packet
+        radio_tx_end();
+
+        // Send bytes from TX buffer
+        radio_transmit();
+    }
+
+    // Send them again if asked
+    radio_repeat(repeat, delay);
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SEND_STAGED
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Swap TX buffers and send packet staged by master, as radio_send() would.
+    Previous packet can then be staged again, or be overwritten by next one.
+*/
+void radio_send_staged(uint8_t channel, uint8_t repeat, uint32_t delay) {
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Use staged packet
+    radio_tx_flip();
+
+    // Send bytes from TX buffer
+    radio_transmit();
+
+    // Send them again if asked
+    radio_repeat(repeat, delay);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SEND_LISTEN
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet from master, then listen for answer on same channel right away,
+    within window given by sync and end deadlines (us, from end of packet).
+    Packet is resent on timeout as many times as asked. Answer goes to master
+    as radio_receive() would give it.
+*/
+uint8_t radio_send_listen(uint8_t channel, uint32_t sync, uint32_t end,
+                          uint8_t retry) {
+
+    // Initialize error and end of packet (us)
+    uint8_t error = 0;
+    uint32_t start;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Get packet
+    radio_tx_begin();
+
+    while (!radio_tx_fill(1)) {
+        NOP();
+    }
+
+    radio_tx_end();
+
+    // Send it and listen, until answer or no retries left
+    while (1) {
+
+        // Send bytes from TX buffer and get end of packet
+        start = radio_transmit_listen(channel);
+
+        // Wait for answer within window, and get error if there is one
+        error = radio_rx_window(start, sync, end);
+
+        // If answer, interruption, or no retries left
+        if (error != RADIO_ERROR_TIMEOUT || retry == 0) {
+
+            // Exit
+            break;
+        }
+
+        // Put radio in idle state
+        radio_rx_stop();
+
+        // Decrease retry count
+        retry--;
+    }
+
+    // If no error
+    if (error == 0) {
+
+        // Send oldest packet to master
+        error = radio_rx_drain();
+    }
+
+    // If error
+    if (error != 0) {
+
+        // Put radio back in idle state
+        radio_rx_stop();
+
+        // End packet master may have started to get
+        radio_rx_cut();
+    }
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SEND_AT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet from master at given time (us, as given by timer_now()): radio
+    waits in FSTXON state, synthesizer calibrated, and timer alarm gives it TX
+    strobe from its ISR, so packet starts within a few us of given time. Past
+    times mean right away. Return error if master interrupted wait (packet not
+    sent then).
+*/
+uint8_t radio_send_at(uint8_t channel, uint32_t time) {
+
+    // Remember packet configuration used for RX
+    uint8_t pktctrl0 = PKTCTRL0;
+    uint8_t pktlen = PKTLEN;
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Get packet
+    radio_tx_begin();
+
+    while (!radio_tx_fill(1)) {
+        NOP();
+    }
+
+    radio_tx_end();
+
+    // Packet length is exactly buffer size
+    PKTCTRL0 = pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+    PKTLEN = radio_tx_buffer_size;
+
+    // Turn synthesizer on
+    RFST = RFST_SFSTXON;
+
+    while (RF_MARCSTATE != RF_MARCSTATE_FSTXON) {
+        NOP();
+    }
+
+    // Prepare DMA
+    radio_tx_arm(0, radio_tx_buffer_size);
+
+    // Put radio in transmit state at given time
+    timer_alarm_set(time, RFST_STX);
+
+    // Wait until then
+    while (timer_alarm != TIMER_ALARM_RANG) {
+
+        // If interruption requested
+        if (usb_poll_byte() != -1) {
+
+            // Assign error
+            error = RADIO_ERROR_INTERRUPTED;
+
+            // Exit
+            break;
+        }
+    }
+
+    // If interrupted
+    if (error != 0) {
+
+        // Cancel alarm, unless it rang meanwhile (packet is then on its way)
+        EA = 0;
+
+        if (timer_alarm == TIMER_ALARM_RANG) {
+            error = 0;
+        }
+
+        timer_alarm_clear();
+        EA = ea;
+    }
+
+    // If interrupted before packet started
+    if (error != 0) {
+
+        // Turn synthesizer off
+        radio_state_idle();
+    }
+
+    // Otherwise
+    else {
+
+        // Wait until packet is transmitted
+        while (RF_MARCSTATE == RF_MARCSTATE_FSTXON) {
+            NOP();
+        }
+
+        radio_state_wait_idle();
+    }
+
+    // Restore packet configuration
+    PKTCTRL0 = pktctrl0;
+    PKTLEN = pktlen;
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_REPEAT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Resend TX buffer given number of times, waiting given delay (ms) before
+    each time.
+*/
+void radio_repeat(uint8_t repeat, uint32_t delay) {
+
+    // If repeat
+    while (repeat > 0) {
+
+        // If delay
+        if (delay > 0) {
+
+            // Wait
+            timer_wait(delay);
+        }
+
+        // Resend bytes from TX buffer
+        radio_resend();
+
+        // Decrease repeat count
+        repeat--;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_BURST
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send packet from master given number of times (e.g. pump wake-up), one
+    starting every given period (us, 0 for back to back), and return time
+    taken from start of first one to end of last one (us). Radio waits in
+    FSTXON state between packets: synthesizer stays on and calibrated, so each
+    packet starts right away. Packets taking longer than period are sent back
+    to back, until schedule is caught up.
+*/
+uint32_t radio_burst(uint8_t channel, uint16_t count, uint32_t period) {
+
+    // Remember packet and state machine configurations used for RX
+    uint8_t pktctrl0 = PKTCTRL0;
+    uint8_t pktlen = PKTLEN;
+    uint8_t mcsm1 = MCSM1;
+
+    // Initialize start times (us)
+    uint32_t start;
+    uint32_t next;
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Get packet
+    radio_tx_begin();
+
+    while (!radio_tx_fill(1)) {
+        NOP();
+    }
+
+    radio_tx_end();
+
+    // Packet length is exactly buffer size
+    PKTCTRL0 = pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+    PKTLEN = radio_tx_buffer_size;
+
+    // Keep synthesizer on after each packet
+    MCSM1 = (mcsm1 & ~RF_MCSM1_TXOFF_MODE_MASK) | RF_MCSM1_TXOFF_MODE_FSTXON;
+
+    // Start now
+    start = timer_now();
+    next = start;
+
+    // Send packets
+    while (count > 0) {
+
+        // Wait until packet is due
+        while ((int32_t) (timer_now() - next) < 0) {
+            NOP();
+        }
+
+        // Prepare DMA
+        radio_tx_arm(0, radio_tx_buffer_size);
+
+        // Put radio in transmit state
+        radio_state_transmit();
+
+        // Wait until packet is transmitted
+        while (RF_MARCSTATE != RF_MARCSTATE_FSTXON) {
+            NOP();
+        }
+
+        // Schedule next one
+        next += period;
+        count--;
+    }
+
+    // Get time taken
+    next = timer_now() - start;
+
+    // Turn synthesizer off
+    radio_state_idle();
+
+    // Restore packet and state machine configurations
+    PKTCTRL0 = pktctrl0;
+    PKTLEN = pktlen;
+    MCSM1 = mcsm1;
+
+    // Return it
+    return next;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TEMPLATE_SAVE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Make template of given index hold given number of packet bytes (as master
+    would send them, patched in afterwards), and return its index (none if
+    unknown index, or too many bytes: template is then emptied). USB framing
+    is left out: no length byte first, and no zero byte last, since
+    radio_tx_load() adds the latter itself. Templates live in XRAM, so they
+    are gone after a reset.
+*/
+uint8_t radio_template_save(uint8_t index, uint8_t size) {
+
+    // If unknown template
+    if (index >= RADIO_TEMPLATES) {
+
+        // Nothing stored
+        return RADIO_TEMPLATE_NONE;
+    }
+
+    // If too many bytes
+    if (size > RADIO_TEMPLATE_SIZE) {
+
+        // Empty template
+        radio_templates[index].size = 0;
+
+        // Nothing stored
+        return RADIO_TEMPLATE_NONE;
+    }
+
+    // Store its size
+    radio_templates[index].size = size;
+
+    // Return its index
+    return index;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TEMPLATE_PATCH
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Overwrite byte of given template (e.g. sequence number). Patch stays for
+    next sends. Bytes beyond template are ignored.
+*/
+void radio_template_patch(uint8_t index, uint8_t offset, uint8_t byte) {
+
+    // If byte in template
+    if (index < RADIO_TEMPLATES && offset < radio_templates[index].size) {
+
+        // Overwrite it
+        radio_templates[index].bytes[offset] = byte;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TEMPLATE_SEND
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send given template on given channel, without master giving its bytes
+    (nothing sent if unknown or empty). It stays in TX buffer for resends, and
+    goes through the same framing and encoding as packets from master. With
+    CRC8 flag, message CRC ending template is computed again, so that patched
+    bytes (e.g. sequence number) can go without it. CRC covers decoded bytes,
+    so flag is ignored unless radio encodes packets.
+*/
+void radio_template_send(uint8_t index, uint8_t channel, uint8_t flags) {
+
+    // Initialize template
+    __xdata struct radio_template *template;
+
+    // If no template
+    if (index >= RADIO_TEMPLATES || radio_templates[index].size == 0) {
+
+        // Nothing to send
+        return;
+    }
+
+    // Get it
+    template = &radio_templates[index];
+
+    // Compute CRC again if asked (template holds decoded bytes)
+    if ((flags & RADIO_TEMPLATE_CRC8) &&
+        (radio_options & RADIO_OPTION_ENCODE)) {
+        template->bytes[template->size - 1] =
+            medtronic_crc8(template->bytes, template->size - 1);
+    }
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Set channel
+    radio_set_channel(channel);
+
+    // Fill TX buffer with template
+    radio_tx_load(template->bytes, template->size);
+
+    // Send bytes from TX buffer
+    radio_transmit();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_RESEND
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void radio_resend(void) {
+
+    // Put radio in idle state
+    radio_rx_stop();
+
+    // Send bytes from TX buffer
+    radio_transmit();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_FLIP
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Swap TX buffer and staged one.
+*/
+void radio_tx_flip(void) {
+
+    // Remember TX buffer and its size
+    __xdata uint8_t *buffer = radio_tx_buffer;
+    uint8_t size = radio_tx_buffer_size;
+
+    // Swap them
+    radio_tx_buffer = radio_tx_staged;
+    radio_tx_buffer_size = radio_tx_staged_size;
+    radio_tx_staged = buffer;
+    radio_tx_staged_size = size;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_STAGE
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Read next packet from master into staged buffer (framed and encoded as for
+    sending), leaving TX buffer alone for resends.
+*/
+void radio_tx_stage(void) {
+
+    // Fill staged buffer instead of TX one
+    radio_tx_flip();
+
+    // Read packet
+    radio_tx_begin();
+
+    while (!radio_tx_fill(1)) {
+        NOP();
+    }
+
+    radio_tx_end();
+
+    // Swap buffers back
+    radio_tx_flip();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_SET_STAGING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Allow master to stage next packet while radio listens, instead of
+    interrupting it. When no longer allowed, packet is read now if it did not
+    come yet.
+*/
+void radio_set_staging(uint8_t staging) {
+
+    // If packet still to come
+    if (!staging && radio_tx_staging) {
+
+        // Stage it
+        radio_tx_stage();
+    }
+
+    // Store it
+    radio_tx_staging = staging;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_BEGIN
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Empty TX buffer, keeping first byte for length with variable packet
+    length. With length framing, read packet length from master (bytes not
+    fitting in buffer will be dropped); it only reaches the air as that
+    length byte.
+*/
+void radio_tx_begin(void) {
+
+    // Reset buffer size
+    radio_tx_buffer_size = 0;
+
+    // If radio expects length byte master doesn't give
+    if (radio_packet == RADIO_PACKET_VARIABLE) {
+
+        // Keep room for it
+        radio_tx_buffer[radio_tx_buffer_size++] = 0;
+    }
+
+    // If master gives packet length first
+    if (radio_framing == USB_FRAMING_LENGTH) {
+
+        // Get it
+        radio_tx_left = usb_rx_word();
+
+        // If radio needs it before bytes (cut-through), write it, as far as
+        // buffer goes
+        if (radio_packet == RADIO_PACKET_VARIABLE) {
+            radio_tx_buffer[0] = radio_tx_left < RADIO_MAX_PACKET_SIZE ?
+                                 radio_tx_left : RADIO_MAX_PACKET_SIZE - 1;
+        }
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_FILL
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Move next byte of packet from master into TX buffer, waiting for it if
+    asked to, and return 1 once the whole packet was read. Packet ends on zero
+    byte (written in buffer), or after announced length with length framing.
+*/
+uint8_t radio_tx_fill(uint8_t wait) {
+
+    // Initialize byte
+    int byte = 0;
+
+    // If packets start with their length
+    if (radio_framing == USB_FRAMING_LENGTH) {
+
+        // If no bytes left
+        if (radio_tx_left == 0) {
+
+            // Packet read
+            return 1;
+        }
+
+        // Get byte
+        byte = wait ? usb_rx_byte() : usb_poll_byte();
+
+        // If none yet
+        if (byte == -1) {
+
+            // Keep trying
+            return 0;
+        }
+
+        // If byte fits in buffer
+        if (radio_tx_buffer_size < RADIO_MAX_PACKET_SIZE) {
+
+            // Write it and update buffer size
+            radio_tx_buffer[radio_tx_buffer_size++] = byte;
+        }
+
+        // Packet read if it was last byte
+        return --radio_tx_left == 0;
+    }
+
+    // If byte is not exceeding max packet length
+    if (radio_tx_buffer_size < RADIO_MAX_PACKET_SIZE - 1) {
+
+        // Get byte
+        byte = wait ? usb_rx_byte() : usb_poll_byte();
+
+        // If none yet
+        if (byte == -1) {
+
+            // Keep trying
+            return 0;
+        }
+    }
+
+    // Write byte in buffer (end byte on overflow) and update its size
+    radio_tx_buffer[radio_tx_buffer_size++] = byte;
+
+    // Packet read if end-of-packet byte
+    return byte == 0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_END
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    With variable packet length, write length byte (dropping zero end byte
+    with zero framing), since radio does not need end byte to end packet.
+    When encoding, bytes (after length byte) are encoded in 4b6b, and
+    followed by a zero symbol ending packet on air unless radio ends it by
+    length (bytes not fitting encoded in buffer are dropped). Only 4b6b
+    symbols and that zero then go on air without packet engine, as MiniMed
+    pumps expect.
+*/
+void radio_tx_end(void) {
+
+    // Initialize first byte to encode, and their number
+    uint8_t start = radio_packet == RADIO_PACKET_VARIABLE;
+    uint8_t n = radio_tx_buffer_size - start;
+
+    // If encoding (master gave packet length, so no end byte)
+    if (radio_options & RADIO_OPTION_ENCODE) {
+
+        // Keep bytes fitting in buffer once encoded
+        if (n > RADIO_MAX_ENCODED_SIZE) {
+            n = RADIO_MAX_ENCODED_SIZE;
+        }
+
+        // Encode them
+        radio_tx_buffer_size = start +
+                               medtronic_encode(&radio_tx_buffer[start], n, 0);
+
+        // End packet, unless radio does it
+        if (radio_packet != RADIO_PACKET_VARIABLE) {
+            radio_tx_buffer[radio_tx_buffer_size++] = 0;
+        }
+    }
+
+    // If room kept for length byte
+    if (radio_packet == RADIO_PACKET_VARIABLE) {
+
+        // Drop end byte master gave
+        if (radio_framing == USB_FRAMING_ZERO) {
+            radio_tx_buffer_size--;
+        }
+
+        // Write length
+        radio_tx_buffer[0] = radio_tx_buffer_size - 1;
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_LOAD
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Fill TX buffer with packet made by firmware itself, as if master had given
+    it (at most max packet size minus 2 bytes).
+*/
+void radio_tx_load(uint8_t *bytes, uint8_t size) {
+
+    // Initialize byte index
+    uint8_t n = 0;
+
+    // Reset buffer size
+    radio_tx_buffer_size = 0;
+
+    // If radio expects length byte
+    if (radio_packet == RADIO_PACKET_VARIABLE) {
+
+        // Keep room for it
+        radio_tx_buffer[radio_tx_buffer_size++] = 0;
+    }
+
+    // Write bytes
+    while (n < size) {
+        radio_tx_buffer[radio_tx_buffer_size++] = bytes[n++];
+    }
+
+    // If packets end with zero byte
+    if (radio_framing == USB_FRAMING_ZERO) {
+
+        // Write it
+        radio_tx_buffer[radio_tx_buffer_size++] = 0;
+    }
+
+    // Finish packet
+    radio_tx_end();
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TX_ARM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Let DMA give bytes [start, end) of TX buffer to radio, one per radio
+    trigger.
+*/
+void radio_tx_arm(uint8_t start, uint8_t end) {
+
+    // Reset DMA interrupt flag
+    DMAIRQ &= ~DMA_MASK_RADIO;
+
+    // Move bytes from buffer to radio
+    dma_configure(DMA_CHANNEL_RADIO,
+                  (uint16_t) &radio_tx_buffer[start],
+                  (uint16_t) &RFDXADDR,
+                  end - start,
+                  DMA_CFG0_WORDSIZE_8 | DMA_CFG0_TMODE_SINGLE |
+                  DMA_CFG0_TRIGGER_RADIO,
+                  DMA_CFG1_SRCINC_1 | DMA_CFG1_DESTINC_0 |
+                  DMA_CFG1_PRIORITY_HIGH);
+
+    // Arm DMA
+    dma_arm(DMA_CHANNEL_RADIO);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TRANSMIT
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send TX buffer as a fixed length packet: radio goes back to idle by itself
+    after exactly the number of bytes in buffer, so no underflow is needed to
+    end it. Length byte of variable length packets is already in buffer.
+    Radio must be idle.
+*/
+void radio_transmit(void) {
+
+    // Remember packet configuration used for RX
+    uint8_t pktctrl0 = PKTCTRL0;
+    uint8_t pktlen = PKTLEN;
+
+    // Packet length is exactly buffer size
+    PKTCTRL0 = pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+    PKTLEN = radio_tx_buffer_size;
+
+    // Prepare DMA
+    radio_tx_arm(0, radio_tx_buffer_size);
+
+    // Put radio in transmit state
+    radio_state_transmit();
+
+    // Wait until packet is transmitted
+    radio_state_wait_idle();
+
+    // Restore packet configuration
+    PKTCTRL0 = pktctrl0;
+    PKTLEN = pktlen;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TRANSMIT_LISTEN
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send TX buffer as radio_transmit() would, but let radio go straight to RX
+    state on same channel once packet is sent (MCSM1 TXOFF_MODE), with no
+    software gap. RX ring is emptied (for given channel radio is on) and opened
+    as soon as radio listens, well before sync word of an answer can end.
+    Return end of packet (us). Radio must be idle.
+*/
+uint32_t radio_transmit_listen(uint8_t channel) {
+
+    // Remember packet and state machine configurations used for RX
+    uint8_t pktctrl0 = PKTCTRL0;
+    uint8_t pktlen = PKTLEN;
+    uint8_t mcsm1 = MCSM1;
+
+    // Initialize end of packet (us)
+    uint32_t time;
+
+    // Packet length is exactly buffer size
+    PKTCTRL0 = pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+    PKTLEN = radio_tx_buffer_size;
+
+    // Listen once packet is sent
+    MCSM1 = (mcsm1 & ~RF_MCSM1_TXOFF_MODE_MASK) | RF_MCSM1_TXOFF_MODE_RX;
+
+    // Empty RX ring
+    radio_rx_reset(channel);
+
+    // Prepare DMA
+    radio_tx_arm(0, radio_tx_buffer_size);
+
+    // Put radio in transmit state
+    radio_state_transmit();
+
+    // Wait until radio listens
+    while (RF_MARCSTATE != RF_MARCSTATE_RX) {
+        NOP();
+    }
+
+    // Get end of packet
+    time = timer_now();
+
+    // Restore packet and state machine configurations
+    PKTCTRL0 = pktctrl0;
+    PKTLEN = pktlen;
+    MCSM1 = mcsm1;
+
+    // Prepare head slot
+    radio_rx_arm();
+
+    // Open ring
+    radio_rx_open = 1;
+
+    // Return end of packet
+    return time;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_TRANSMIT_CUT_THROUGH
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Fill TX buffer from master and start transmitting as soon as a few bytes
+    are in it, instead of waiting for the whole packet. Packet length is
+    unknown until the last byte comes, so radio starts in infinite length mode
+    and is switched to fixed length mode then. Every time DMA gave radio all
+    bytes buffered so far, it is re-armed with the new ones, which must happen
+    before radio needs the next byte (one byte time, ~0.5 ms): if not, radio
+    underflows and packet is lost (whole buffer is still read from master, and
+    can be resent), which is returned as error. Radio must be idle.
+*/
+uint8_t radio_transmit_cut_through(void) {
+
+    // Initialize error
+    uint8_t error = 0;
+
+    // Remember packet configuration used for RX
+    uint8_t pktctrl0 = PKTCTRL0;
+    uint8_t pktlen = PKTLEN;
+
+    // Initialize number of bytes given to DMA
+    uint8_t n = 0;
+
+    // Initialize TX states
+    uint8_t end = 0;
+    uint8_t started = 0;
+
+    // Packet length unknown yet
+    PKTCTRL0 = (pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK) |
+               RF_PKTCTRL0_LENGTH_CONFIG_INFINITE;
+
+    // Loop until all bytes read from master and given to DMA
+    while (!end || n < radio_tx_buffer_size) {
+
+        // If bytes remaining and last one just read
+        if (!end && radio_tx_fill(0)) {
+
+            // End packet right after it
+            PKTLEN = radio_tx_buffer_size;
+            PKTCTRL0 = pktctrl0 & ~RF_PKTCTRL0_LENGTH_CONFIG_MASK;
+
+            // No more bytes
+            end = 1;
+        }
+
+        // If enough bytes to start transmitting
+        if (!started) {
+
+            // If threshold reached or packet short
+            if (end || radio_tx_buffer_size >= RADIO_TX_THRESHOLD) {
+
+                // Give buffered bytes to DMA
+                n = radio_tx_buffer_size;
+                radio_tx_arm(0, n);
+
+                // Put radio in transmit state
+                radio_state_transmit();
+
+                // Update state
+                started = 1;
+            }
+        }
+
+        // If radio stopped before end of packet
+        else if (RF_MARCSTATE != RF_MARCSTATE_TX) {
+
+            // Update statistics
+            radio_stats.tx_underflows++;
+
+            // Assign error
+            error = RADIO_ERROR_UNDERFLOW;
+
+            // Leave underflow state
+            radio_state_idle();
+
+            // Stop giving bytes to radio, but keep reading them from master
+            n = RADIO_MAX_PACKET_SIZE;
+        }
+
+        // If DMA gave radio all bytes it had, and new ones came
+        else if ((DMAIRQ & DMA_MASK_RADIO) && n < radio_tx_buffer_size) {
+
+            // Update statistics
+            radio_stats.tx_lead_min = min(radio_stats.tx_lead_min,
+                                          radio_tx_buffer_size - n);
+
+            // Give them to DMA
+            radio_tx_arm(n, radio_tx_buffer_size);
+            n = radio_tx_buffer_size;
+        }
+    }
+
+    // Wait until packet is transmitted
+    radio_state_wait_idle();
+
+    // Restore packet configuration
+    PKTCTRL0 = pktctrl0;
+    PKTLEN = pktlen;
+
+    // Update statistics
+    radio_stats.tx_cut_through++;
+
+    // Return error
+    return error;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GET_STATS
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Send statistics to master, field by field in order of declaration, MSB
+    first (as every other multi-byte value).
+*/
+void radio_get_stats(void) {
+
+    // Initialize bytes
+    uint8_t bytes[RADIO_STATS_SIZE];
+
+    // Write fields
+    bytes[0] = radio_stats.tx_cut_through >> 8;
+    bytes[1] = radio_stats.tx_cut_through;
+    bytes[2] = radio_stats.tx_underflows >> 8;
+    bytes[3] = radio_stats.tx_underflows;
+    bytes[4] = radio_stats.tx_lead_min;
+    bytes[5] = radio_stats.rx_filtered >> 8;
+    bytes[6] = radio_stats.rx_filtered;
+
+    // Send them
+    usb_tx_bytes(bytes, RADIO_STATS_SIZE);
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_GENERAL_ISR
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void radio_general_isr(void) __interrupt RF_VECTOR {
+
+    // Initialize RSSI and time
+    uint8_t rssi = 0;
+    uint32_t time = 0;
 
     // TX underflow
     if (RFIF & RFIF_IM_TXUNF) {
@@ -610,8 +3224,19 @@ void radio_general_isr(void) __interrupt RF_VECTOR {
     // RX overflow
     if (RFIF & RFIF_IM_RXOVF) {
 
-        // Put radio back in idle state
-        radio_state_idle();
+        // If receiving in RX ring
+        if (radio_rx_open) {
+
+            // Drop broken packet and go on listening with next slot
+            radio_rx_end(0);
+        }
+
+        // Otherwise
+        else {
+
+            // Put radio back in idle state
+            radio_state_idle();
+        }
 
         // Reset interrupt flag
         RFIF &= ~RFIF_IM_RXOVF;
@@ -629,6 +3254,13 @@ void radio_general_isr(void) __interrupt RF_VECTOR {
 
         // Reset interrupt flag
         RFIF &= ~RFIF_IM_DONE;
+
+        // If packet engine ended packet in RX ring
+        if (radio_rx_open && radio_packet != RADIO_PACKET_SOFTWARE) {
+
+            // Next slot
+            radio_rx_next(radio_rx_length(radio_rx_buffer));
+        }
     }
 
     // CS
@@ -655,10 +3287,82 @@ void radio_general_isr(void) __interrupt RF_VECTOR {
     // SFD
     if (RFIF & RFIF_IM_SFD) {
 
+        // If receiving in RX ring
+        if (radio_rx_open && RF_MARCSTATE == RF_MARCSTATE_RX) {
+
+            // If packet engine dropped last packet (too long) and restarted
+            // RX, move bytes into slot from its start again
+            if (radio_rx_buffer_size > 0 &&
+                radio_packet != RADIO_PACKET_SOFTWARE) {
+                dma_abort(DMA_CHANNEL_RADIO);
+                radio_rx_arm();
+            }
+
+            // New packet: update count and avoid end-of-packet due to byte
+            // overflow
+            if (++radio_packet_count == 0) {
+                radio_packet_count = 1;
+            }
+
+            // First byte: packet count
+            radio_rx_buffer[0] = radio_packet_count;
+
+            // Second byte: received signal strength indication (RSSI)
+            // Minimum set to 1 to avoid end-of-packet zero, unless packets
+            // start with their length
+            rssi = RF_RSSI;
+
+            if (rssi == 0 && radio_framing == USB_FRAMING_ZERO) {
+                rssi = 1;
+            }
+
+            radio_rx_buffer[1] = rssi;
+
+            // Next bytes: arrival time (us, MSB first)
+            if (radio_options & RADIO_OPTION_TIMESTAMP) {
+                time = timer_now();
+                radio_rx_buffer[2] = time >> 24;
+                radio_rx_buffer[3] = time >> 16;
+                radio_rx_buffer[4] = time >> 8;
+                radio_rx_buffer[5] = time;
+            }
+
+            // Update buffer size
+            radio_rx_buffer_size = radio_rx_header;
+        }
+
         // Reset interrupt flag
         RFIF &= ~RFIF_IM_SFD;
     }
 
     // Reset CPU interrupt flags
     S1CON = 0;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    RADIO_DMA_ISR
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    ISRs when DMA has filled RX buffer: packet ends there, unless a zero byte
+    ended it before.
+*/
+void radio_dma_isr(void) __interrupt DMA_VECTOR {
+
+    // Reset CPU interrupt flag
+    DMAIF = 0;
+
+    // RX buffer full
+    if (DMAIRQ & DMA_MASK_RADIO) {
+
+        // Reset interrupt flag
+        DMAIRQ &= ~DMA_MASK_RADIO;
+
+        // If still listening, and no zero byte ends packet earlier (bytes
+        // after it are noise)
+        if (radio_rx_open && !radio_rx_poll(RADIO_MAX_PACKET_SIZE)) {
+
+            // Next slot (full)
+            radio_rx_next(RADIO_MAX_PACKET_SIZE);
+        }
+    }
 }
\ No newline at end of file
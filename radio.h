@@ -6,6 +6,9 @@
 #include "timer.h"
 #include "led.h"
 #include "usb.h"
+#include "dma.h"
+#include "flash.h"
+#include "medtronic.h"
 
 // Radio states
 #define RADIO_STATE_IDLE        0
@@ -16,17 +19,160 @@
 #define RADIO_STATE_TX_OVERFLOW 5
 
 // Radio locale
-#define RADIO_LOCALE_NA 0
-#define RADIO_LOCALE_WW 1
-#define RADIO_LOCALE    RADIO_LOCALE_NA
+#define RADIO_LOCALE_NA   0
+#define RADIO_LOCALE_WW   1
+#define RADIO_LOCALES     2
+#define RADIO_LOCALE_NONE 0xFF            // Band set by hand
+#define RADIO_LOCALE      RADIO_LOCALE_NA // At startup
+
+// Time to wait for an answer in each locale when detecting it, if none given
+// (ms)
+#define RADIO_LOCALE_TIMEOUT 500
 
 // Max packet size
 #define RADIO_MAX_PACKET_SIZE 248
 
+// RX header size (packet count and RSSI), and optional timestamp, metadata
+// (LQI, FREQEST and length) and 4b6b symbol error count sizes
+#define RADIO_HEADER_SIZE    2
+#define RADIO_TIMESTAMP_SIZE 4
+#define RADIO_METADATA_SIZE  3
+#define RADIO_DECODE_SIZE    1
+
+// Max number of TX bytes to encode (length byte and zero end byte excluded)
+#define RADIO_MAX_ENCODED_SIZE ((RADIO_MAX_PACKET_SIZE - 2) * 2 / 3)
+
+// RX ring slots (power of 2, 4 x 248 B of 0x0F00 B of XRAM)
+#define RADIO_RX_SLOTS 4
+
+// RX buffer filler (never found in 4b6b encoded data)
+#define RADIO_RX_FILL 0xFF
+
+// Max number of RX bytes gone through per poll (~8 ms at MiniMed data rate,
+// polled every ms)
+#define RADIO_RX_POLL_BYTES 16
+
+// Radio registers accessible to master
+#define RADIO_REGISTERS 36
+
+// Radio profiles: built-in ones (locales first), then user ones in flash
+#define RADIO_PROFILE_NAME_SIZE 8
+#define RADIO_PROFILES_BUILTIN  2
+#define RADIO_PROFILES_USER     8
+#define RADIO_PROFILES_ADDR     (FLASH_PAGE_PROFILES * FLASH_PAGE_SIZE)
+#define RADIO_PROFILE_NONE      0xFF
+
+// Channels whose calibration can be cached (0 to N - 1)
+#define RADIO_CAL_CHANNELS 16
+
+// Frequency offset corrections: fixed point (1/16 of FSCTRL0 step), share of
+// each estimate taken (1/4), and max (FSCTRL0 range)
+#define RADIO_AFC_SHIFT 4
+#define RADIO_AFC_SCALE (1 << RADIO_AFC_SHIFT)
+#define RADIO_AFC_GAIN  4
+#define RADIO_AFC_MAX   (127 * RADIO_AFC_SCALE)
+
+// Cut-through TX: bytes to buffer before starting to transmit
+#define RADIO_TX_THRESHOLD 16
+
+// Radio packet modes (how radio knows where packets end)
+#define RADIO_PACKET_SOFTWARE 0 // Zero byte or DMA (radio ignores length)
+#define RADIO_PACKET_FIXED    1 // Packet engine: fixed length
+#define RADIO_PACKET_VARIABLE 2 // Packet engine: length in first byte
+#define RADIO_PACKETS         3
+
+// CRC checks of received packets (low bits), and retry flag of send/receive
+#define RADIO_CRC_CHECK_NONE 0
+#define RADIO_CRC_CHECK_8    1 // Messages: CRC8 in last decoded byte
+#define RADIO_CRC_CHECKS     2
+#define RADIO_CRC_CHECK_MASK 0x0F
+#define RADIO_CRC_RETRY      (1 << 7)
+
+// RX address filter: max number of bytes compared on air, and flag asking
+// for 4b6b encoding of bytes given
+#define RADIO_FILTER_SIZE 8
+#define RADIO_FILTER_4B6B (1 << 0)
+
+// TX templates: number, max size, no template, and flag asking for CRC8 in
+// last byte to be computed again when sending
+#define RADIO_TEMPLATES     4
+#define RADIO_TEMPLATE_SIZE 64
+#define RADIO_TEMPLATE_NONE 0xFF
+#define RADIO_TEMPLATE_CRC8 (1 << 0)
+
+// Radio options
+#define RADIO_OPTION_RX_CUT_THROUGH (1 << 0)
+#define RADIO_OPTION_TX_CUT_THROUGH (1 << 1)
+#define RADIO_OPTION_CAL_CACHE      (1 << 2)
+#define RADIO_OPTION_TIMESTAMP      (1 << 3)
+#define RADIO_OPTION_METADATA       (1 << 4)
+#define RADIO_OPTION_AFC            (1 << 5)
+#define RADIO_OPTION_DECODE         (1 << 6)
+#define RADIO_OPTION_ENCODE         (1 << 7)
+#define RADIO_OPTIONS               (RADIO_OPTION_RX_CUT_THROUGH | \
+                                     RADIO_OPTION_TX_CUT_THROUGH | \
+                                     RADIO_OPTION_CAL_CACHE |      \
+                                     RADIO_OPTION_TIMESTAMP |      \
+                                     RADIO_OPTION_METADATA |       \
+                                     RADIO_OPTION_AFC |            \
+                                     RADIO_OPTION_DECODE |         \
+                                     RADIO_OPTION_ENCODE)
+#define RADIO_OPTIONS_FRAMED        (RADIO_OPTION_TIMESTAMP | \
+                                     RADIO_OPTION_METADATA |  \
+                                     RADIO_OPTION_DECODE |    \
+                                     RADIO_OPTION_ENCODE)
+
 // Radio errors
 #define RADIO_ERROR_TIMEOUT     0xAA
 #define RADIO_ERROR_NO_DATA     0xBB
 #define RADIO_ERROR_INTERRUPTED 0xCC
+#define RADIO_ERROR_CRC         0xDD
+#define RADIO_ERROR_FRAMING     0xEE
+#define RADIO_ERROR_UNDERFLOW   0xFF
+
+// Radio profile (register values in order of their addresses)
+struct radio_profile {
+    uint8_t name[RADIO_PROFILE_NAME_SIZE];
+    uint8_t values[RADIO_REGISTERS];
+};
+
+// Radio locale (band settings)
+struct radio_locale {
+    uint8_t freq2;
+    uint8_t freq1;
+    uint8_t freq0;
+    uint8_t pa_table1;
+};
+
+// Radio frequency synthesizer calibration
+struct radio_cal {
+    uint8_t fscal3;
+    uint8_t fscal2;
+    uint8_t fscal1;
+};
+
+// Radio statistics (and number of bytes they take for master)
+#define RADIO_STATS_SIZE 7
+
+struct radio_stats {
+    uint16_t tx_cut_through;
+    uint16_t tx_underflows;
+    uint8_t tx_lead_min;
+    uint16_t rx_filtered;
+};
+
+// Radio TX template
+struct radio_template {
+    uint8_t size;
+    uint8_t bytes[RADIO_TEMPLATE_SIZE];
+};
+
+// Radio RX address filter
+struct radio_filter {
+    uint8_t size;
+    uint8_t bytes[RADIO_FILTER_SIZE];
+    uint8_t mask[RADIO_FILTER_SIZE];
+};
 
 void radio_init(void);
 void radio_enable_interrupts(void);
@@ -36,10 +182,81 @@ void radio_state_receive(void);
 void radio_state_transmit(void);
 void radio_configure(void);
 uint8_t * radio_register(uint8_t addr);
+void radio_apply(uint8_t *values);
+struct radio_profile * radio_profile(uint8_t index);
+uint8_t radio_profile_apply(uint8_t index);
+void radio_profiles_load(void);
+void radio_profiles_store(void);
+uint8_t radio_profile_save(uint8_t index, uint8_t *name);
+uint8_t radio_profile_erase(uint8_t index);
+void radio_set_channel(uint8_t channel);
+void radio_cal_channel(uint8_t channel);
+void radio_cal_clear(void);
+void radio_afc_apply(void);
+void radio_afc_update(int8_t freqest);
+uint8_t radio_calibrate(void);
+uint8_t radio_set_locale(uint8_t locale);
+uint8_t radio_get_locale(void);
+uint8_t radio_detect_locale(uint8_t tx_channel, uint8_t rx_channel,
+                            uint32_t timeout);
+void radio_rx_clear(uint8_t slot);
+void radio_rx_arm(void);
+void radio_rx_reset(uint8_t channel);
+void radio_rx_start(uint8_t channel);
+void radio_rx_stop(void);
+uint8_t radio_rx_data(void);
+uint8_t radio_rx_match(uint8_t size);
+void radio_rx_drop(void);
+void radio_rx_end(uint8_t size);
+void radio_rx_next(uint8_t size);
+uint8_t radio_rx_poll(uint8_t max);
+uint8_t radio_rx_length(__xdata uint8_t *packet);
+uint8_t radio_rx_decode(__xdata uint8_t *packet, uint8_t size);
+uint8_t radio_rx_check(__xdata uint8_t *packet, uint8_t size);
+void radio_rx_passed(void);
+__xdata uint8_t * radio_rx_take(uint8_t *size);
+uint8_t radio_rx_drain(void);
+void radio_rx_free(void);
+uint8_t radio_rx_ready(void);
+void radio_rx_forward(void);
+void radio_rx_cut(void);
+uint8_t radio_set_options(uint8_t options);
+uint8_t radio_get_options(void);
+uint8_t radio_set_framing(uint8_t framing);
+uint8_t radio_get_framing(void);
+uint8_t radio_set_packet(uint8_t packet, uint8_t length);
+uint8_t radio_set_crc(uint8_t crc);
+uint8_t radio_set_filter(uint8_t flags, uint8_t size, uint8_t *bytes,
+                         uint8_t *mask);
+uint8_t radio_get_crc(void);
+uint8_t radio_rx_wait(uint8_t channel, uint32_t timeout);
+uint8_t radio_rx_window(uint32_t start, uint32_t sync, uint32_t end);
 uint8_t radio_receive(uint8_t channel, uint32_t timeout);
-void radio_send(uint8_t channel, uint8_t repeat, uint32_t delay);
+uint8_t radio_stream(uint8_t channel, uint32_t timeout);
+uint8_t radio_send(uint8_t channel, uint8_t repeat, uint32_t delay);
+void radio_send_staged(uint8_t channel, uint8_t repeat, uint32_t delay);
+uint8_t radio_send_listen(uint8_t channel, uint32_t sync, uint32_t end,
+                          uint8_t retry);
+uint8_t radio_send_at(uint8_t channel, uint32_t time);
+void radio_repeat(uint8_t repeat, uint32_t delay);
+uint32_t radio_burst(uint8_t channel, uint16_t count, uint32_t period);
+uint8_t radio_template_save(uint8_t index, uint8_t size);
+void radio_template_patch(uint8_t index, uint8_t offset, uint8_t byte);
+void radio_template_send(uint8_t index, uint8_t channel, uint8_t flags);
 void radio_resend(void);
-void radio_rftxrx_isr(void) __interrupt RFTXRX_VECTOR;
+void radio_tx_flip(void);
+void radio_tx_stage(void);
+void radio_set_staging(uint8_t staging);
+void radio_tx_begin(void);
+uint8_t radio_tx_fill(uint8_t wait);
+void radio_tx_end(void);
+void radio_tx_load(uint8_t *bytes, uint8_t size);
+void radio_tx_arm(uint8_t start, uint8_t end);
+void radio_transmit(void);
+uint32_t radio_transmit_listen(uint8_t channel);
+uint8_t radio_transmit_cut_through(void);
+void radio_get_stats(void);
 void radio_general_isr(void) __interrupt RF_VECTOR;
+void radio_dma_isr(void) __interrupt DMA_VECTOR;
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "timer.h"
+#include "radio.h"
 
 // Preprocessor cannot deal with floating points!
 
@@ -10,6 +11,19 @@
 // Define counter (ms)
 volatile uint32_t timer_counter = 0;
 
+// Define clock (ms since timer started, never reset)
+volatile uint32_t timer_clock = 0;
+
+// Define alarm state
+volatile uint8_t timer_alarm = TIMER_ALARM_OFF;
+
+// Define when alarm rings (clock value, and ticks after it)
+static uint32_t timer_alarm_clock = 0;
+static uint16_t timer_alarm_ticks = 0;
+
+// Define radio command strobe given when alarm rings
+static uint8_t timer_alarm_strobe = TIMER_STROBE_NONE;
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     TIMER_INIT
@@ -77,6 +91,174 @@ void timer_wait(uint32_t delay) {
     }
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    TIMER_NOW
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Return time since timer started (us), from clock and timer ticks since its
+    last update (1.33 us each). Wraps after ~71 minutes. Can be called from
+    ISRs.
+*/
+uint32_t timer_now(void) {
+
+    // Initialize clock and ticks
+    uint32_t clock;
+    uint16_t ticks;
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // Read clock and timer together (low byte first: it latches high one)
+    EA = 0;
+    clock = timer_clock;
+    ticks = T1CNTL;
+    ticks |= (uint16_t) T1CNTH << 8;
+    ticks -= GET_WORD(T1CC0) - N;
+    EA = ea;
+
+    // If clock update still pending
+    if (ticks >= N) {
+        clock++;
+        ticks -= N;
+    }
+
+    // Return time
+    return clock * 1000 + ticks * 4 / 3;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    TIMER_ALARM_SET
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Make alarm ring at given time (us, as given by timer_now()), at most ~35
+    minutes ahead: times further away are taken as past ones, and ring right
+    away. Clock interrupt arms channel 1 compare during the millisecond alarm
+    falls in, so alarm rings within a tick (1.33 us) of given time. Radio gets
+    given command strobe (if any) right from ISR when alarm rings.
+*/
+void timer_alarm_set(uint32_t time, uint8_t strobe) {
+
+    // Initialize ticks since last clock update, and until alarm
+    uint16_t ticks;
+    uint32_t n;
+
+    // Remember interrupt state
+    uint8_t ea = EA;
+
+    // Stop clock interrupt while alarm changes
+    EA = 0;
+
+    // Disarm previous alarm
+    timer_alarm_clear();
+
+    // Store strobe
+    timer_alarm_strobe = strobe;
+
+    // Get time until alarm
+    n = time - timer_now();
+
+    // If alarm already due
+    if ((int32_t) n <= 0) {
+
+        // Ring it
+        timer_alarm_ring();
+    }
+
+    // Otherwise
+    else {
+
+        // Get clock update alarm follows, and ticks after it
+        ticks = T1CNTL;
+        ticks |= (uint16_t) T1CNTH << 8;
+        ticks -= GET_WORD(T1CC0) - N;
+        n = ticks + (n - n / 4);
+        timer_alarm_clock = timer_clock + n / N;
+        timer_alarm_ticks = n % N;
+
+        // Alarm is set
+        timer_alarm = TIMER_ALARM_SET;
+
+        // If it falls before next clock update
+        if (timer_alarm_clock == timer_clock) {
+
+            // Arm compare
+            timer_alarm_arm(GET_WORD(T1CC0) - N);
+        }
+    }
+
+    // Restore interrupt state
+    EA = ea;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    TIMER_ALARM_CLEAR
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+*/
+void timer_alarm_clear(void) {
+
+    // Disarm compare
+    T1CCTL1 = 0;
+
+    // Reset alarm and strobe
+    timer_alarm = TIMER_ALARM_OFF;
+    timer_alarm_strobe = TIMER_STROBE_NONE;
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    TIMER_ALARM_ARM
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Make channel 1 compare fire at alarm ticks after given timer count (clock
+    update alarm follows). If timer already went past it, alarm rings now.
+    Called with interrupts off, or from ISR.
+*/
+void timer_alarm_arm(uint16_t base) {
+
+    // Initialize timer count
+    uint16_t count;
+
+    // Set compare value
+    SET_WORD(T1CC1, base + timer_alarm_ticks);
+
+    // Enable compare interrupt
+    T1CCTL1 = T1CCTL_MODE_COMPARE | T1CCTL_IM_ENABLED;
+
+    // Read timer count
+    count = T1CNTL;
+    count |= (uint16_t) T1CNTH << 8;
+
+    // If compare value already passed
+    if ((uint16_t) (count - base) >= timer_alarm_ticks) {
+
+        // Ring alarm
+        timer_alarm_ring();
+    }
+}
+
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    TIMER_ALARM_RING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Called with interrupts off, or from ISR.
+*/
+void timer_alarm_ring(void) {
+
+    // If strobe wanted
+    if (timer_alarm_strobe != TIMER_STROBE_NONE) {
+
+        // Give it to radio
+        RFST = timer_alarm_strobe;
+        timer_alarm_strobe = TIMER_STROBE_NONE;
+    }
+
+    // Disarm compare
+    T1CCTL1 = 0;
+
+    // Alarm rang
+    timer_alarm = TIMER_ALARM_RANG;
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     TIMER_ISR
@@ -85,12 +267,46 @@ void timer_wait(uint32_t delay) {
 */
 void timer_isr(void) __interrupt T1_VECTOR {
 
-    // Read current compare value and update it (leapfrogging)
-    SET_WORD(T1CC0, GET_WORD(T1CC0) + N);
+    // Initialize compare value of clock update
+    uint16_t base;
+
+    // Clock update
+    if (T1CTL & T1CTL_CH0IF) {
 
-    // Update counter
-    timer_counter++;
+        // Read current compare value and update it (leapfrogging)
+        base = GET_WORD(T1CC0);
+        SET_WORD(T1CC0, base + N);
 
-    // Reset interrupt flag
-    T1CTL &= ~T1CTL_CH0IF;
+        // Update counter and clock
+        timer_counter++;
+        timer_clock++;
+
+        // Look for end of packet being received
+        radio_rx_poll(RADIO_RX_POLL_BYTES);
+
+        // If alarm falls before next clock update
+        if (timer_alarm == TIMER_ALARM_SET &&
+            timer_alarm_clock == timer_clock) {
+
+            // Arm compare
+            timer_alarm_arm(base);
+        }
+
+        // Reset interrupt flag
+        T1CTL &= ~T1CTL_CH0IF;
+    }
+
+    // Alarm
+    if (T1CTL & T1CTL_CH1IF) {
+
+        // If armed
+        if (T1CCTL1 & T1CCTL_IM_ENABLED) {
+
+            // Ring it
+            timer_alarm_ring();
+        }
+
+        // Reset interrupt flag
+        T1CTL &= ~T1CTL_CH1IF;
+    }
 }
\ No newline at end of file
@@ -5,13 +5,28 @@
 #include "led.h"
 #include "lib.h"
 
+// Alarm states
+#define TIMER_ALARM_OFF  0
+#define TIMER_ALARM_SET  1
+#define TIMER_ALARM_RANG 2
+
+// No radio command strobe when alarm rings
+#define TIMER_STROBE_NONE 0xFF
+
 // Declare external variables
 extern volatile uint32_t timer_counter;
+extern volatile uint32_t timer_clock;
+extern volatile uint8_t timer_alarm;
 
 void timer_init(void);
 void timer_start(void);
 void timer_counter_reset(void);
 void timer_wait(uint32_t delay);
+uint32_t timer_now(void);
+void timer_alarm_set(uint32_t time, uint8_t strobe);
+void timer_alarm_clear(void);
+void timer_alarm_arm(uint16_t base);
+void timer_alarm_ring(void);
 void timer_isr(void) __interrupt T1_VECTOR;
 
 #endif
\ No newline at end of file
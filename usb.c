@@ -24,6 +24,9 @@ volatile static uint8_t usb_if_out = 0;
 // Initialize EP0 state
 static uint8_t usb_ep0_state = USB_STATE_IDLE;
 
+// Initialize framing of bytes exchanged with master on data EPs
+static uint8_t usb_framing = USB_FRAMING_ZERO;
+
 // USB descriptors
 __xdata uint8_t usb_descriptors[] = {
 
@@ -516,6 +519,24 @@ void usb_put_byte(uint8_t byte) {
     }
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    USB_PUT_LENGTH
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Tell master how many bytes follow, if framing uses lengths. Must come
+    before first byte of packet.
+*/
+void usb_put_length(uint16_t length) {
+
+    // If framing uses lengths
+    if (usb_framing == USB_FRAMING_LENGTH) {
+
+        // Put length (MSB first)
+        usb_put_byte(length >> 8);
+        usb_put_byte(length & 0xFF);
+    }
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     USB_FLUSH_BYTES
@@ -524,8 +545,12 @@ void usb_put_byte(uint8_t byte) {
 */
 void usb_flush_bytes(void) {
 
-    // Put last byte to tell master bytes end here
-    usb_put_byte(0);
+    // If framing uses end byte
+    if (usb_framing == USB_FRAMING_ZERO) {
+
+        // Put last byte to tell master bytes end here
+        usb_put_byte(0);
+    }
 
     // If bytes remaining or last packet was full
     if (usb_n_bytes.ep_in || usb_n_bytes.ep_in_last == USB_SIZE_EP_IN) {
@@ -546,6 +571,9 @@ void usb_flush_bytes(void) {
 */
 void usb_tx_byte(uint8_t byte) {
 
+    // Put length
+    usb_put_length(1);
+
     // Put byte
     usb_put_byte(byte);
 
@@ -564,6 +592,9 @@ void usb_tx_bytes(uint8_t *bytes, uint8_t size) {
     // Initialize byte count
     uint8_t n = 0;
 
+    // Put length
+    usb_put_length(size);
+
     // Write bytes
     while (size--) {
 
@@ -627,6 +658,28 @@ int usb_poll_byte(void) {
     return byte;
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    USB_RX_READY
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Tell whether master sent bytes on EP OUT, without reading any.
+*/
+uint8_t usb_rx_ready(void) {
+
+    // If bytes left in packet being read
+    if (usb_n_bytes.ep_out > 0) {
+
+        // Ready
+        return 1;
+    }
+
+    // Select EP
+    usb_set_ep(USB_EP_OUT);
+
+    // Ready if packet came
+    return (USBCSOL & USBCSOL_OUTPKT_RDY) != 0;
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     USB_RX_BYTE
@@ -671,6 +724,26 @@ uint32_t usb_rx_long(void) {
     return ((uint32_t) usb_rx_word() << 16) + usb_rx_word();
 }
 
+/*
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    USB_SET_FRAMING
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    Choose how packets exchanged with master end, and return framing applied
+    (unknown ones are ignored).
+*/
+uint8_t usb_set_framing(uint8_t framing) {
+
+    // If framing known
+    if (framing < USB_FRAMINGS) {
+
+        // Store it
+        usb_framing = framing;
+    }
+
+    // Return it
+    return usb_framing;
+}
+
 /*
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     USB_SET_ADDRESS
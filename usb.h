@@ -104,6 +104,11 @@
 #define USB_STATE_SEND    1
 #define USB_STATE_RECEIVE 2
 
+// USB framings (how master and device tell where bytes end)
+#define USB_FRAMING_ZERO   0 // Trailing zero byte
+#define USB_FRAMING_LENGTH 1 // Leading 2-byte length
+#define USB_FRAMINGS       2
+
 // USB vendor and product IDs
 #define USB_VID 0x0451
 #define USB_PID 0x16A7
@@ -204,13 +209,16 @@ void usb_send_bytes(void);
 void usb_received_bytes(void);
 void usb_wait_in(void);
 void usb_put_byte(uint8_t byte);
+void usb_put_length(uint16_t length);
 void usb_flush_bytes(void);
 void usb_tx_byte(uint8_t byte);
 void usb_tx_bytes(uint8_t *bytes, uint8_t size);
 int usb_poll_byte(void);
+uint8_t usb_rx_ready(void);
 uint8_t usb_rx_byte(void);
 uint16_t usb_rx_word(void);
 uint32_t usb_rx_long(void);
+uint8_t usb_set_framing(uint8_t framing);
 void usb_set_address(uint8_t addr);
 void usb_set_configuration(uint8_t value);
 void usb_get_configuration(void);